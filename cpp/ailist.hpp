@@ -0,0 +1,121 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "lapper.hpp"
+
+// Augmented Interval List (Feng, Ratan and Sheffield, 2019).
+//
+// An alternative to Lapper for heavily nested data. The start-sorted input
+// is decomposed into a few components: an interval that contains many of its
+// immediate successors is moved on to the next component, so each component
+// is left with few containment relations. Every component carries a running
+// max of stops, and a query walks backwards from the last start < stop until
+// that running max drops to the query start. No global max_len is involved.
+//
+// Same SoA layout as Lapper: each component is a contiguous slice of the
+// starts/stops/vals/max_ends columns.
+class AIList {
+public:
+  struct Component {
+    size_t offset;
+    size_t length;
+  };
+
+  // Number of successors checked when deciding whether an interval is a
+  // container, and how many of them it must cover to be moved on.
+  static constexpr int cov_window = 20;
+  static constexpr int min_cov = cov_window / 2;
+  // Components smaller than this are not decomposed further.
+  static constexpr size_t min_component = 64;
+  static constexpr int max_components = 10;
+
+private:
+  std::vector<uint32_t> starts;
+  std::vector<uint32_t> stops;
+  std::vector<int32_t> vals;
+  std::vector<uint32_t> max_ends;
+  std::vector<Component> components;
+
+  void append_component(const std::vector<Interval> &list) {
+    size_t offset = starts.size();
+    components.push_back({offset, list.size()});
+    uint32_t running = 0;
+    for (const Interval &iv : list) {
+      starts.push_back(iv.start);
+      stops.push_back(iv.stop);
+      vals.push_back(iv.val);
+      running = std::max(running, iv.stop);
+      max_ends.push_back(running);
+    }
+  }
+
+  void fill(std::vector<Interval> &intervals) {
+    sort_intervals(intervals);
+    starts.reserve(intervals.size());
+    stops.reserve(intervals.size());
+    vals.reserve(intervals.size());
+    max_ends.reserve(intervals.size());
+
+    std::vector<Interval> keep, rest;
+    for (int comp = 0; !intervals.empty(); comp++) {
+      if (intervals.size() > min_component && comp < max_components - 1) {
+        keep.clear();
+        rest.clear();
+        size_t n = intervals.size();
+        for (size_t i = 0; i < n; i++) {
+          int covered = 0;
+          size_t end = std::min(n, i + 1 + cov_window);
+          for (size_t j = i + 1; j < end && covered < min_cov; j++)
+            covered += intervals[j].stop <= intervals[i].stop;
+          (covered >= min_cov ? rest : keep).push_back(intervals[i]);
+        }
+        if (rest.size() >= min_component) {
+          append_component(keep);
+          std::swap(intervals, rest);
+          continue;
+        }
+      }
+      append_component(intervals);
+      break;
+    }
+  }
+
+  // Visits every overlapping row of component c, last start first.
+  template <typename F>
+  void walk(const Component &c, uint32_t start, uint32_t stop, F &&f) const {
+    const uint32_t *first = starts.data() + c.offset;
+    const uint32_t *last = first + c.length;
+    size_t end = std::lower_bound(first, last, stop) - starts.data();
+    for (size_t i = end; i-- > c.offset && max_ends[i] > start;) {
+      if (stops[i] > start)
+        f(i);
+    }
+  }
+
+public:
+  explicit AIList(std::vector<Interval> intervals) { fill(intervals); }
+
+  // Appends every interval overlapping [start, stop) to results. Results are
+  // grouped by component, in descending start order within a component.
+  void find(uint32_t start, uint32_t stop,
+            std::vector<Interval> &results) const {
+    for (const Component &c : components)
+      walk(c, start, stop, [&](size_t i) {
+        results.push_back({starts[i], stops[i], vals[i]});
+      });
+  }
+
+  size_t count(uint32_t start, uint32_t stop) const {
+    size_t n = 0;
+    for (const Component &c : components)
+      walk(c, start, stop, [&](size_t) { n++; });
+    return n;
+  }
+
+  size_t size() const { return starts.size(); }
+
+  size_t num_components() const { return components.size(); }
+};
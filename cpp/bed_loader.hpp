@@ -0,0 +1,225 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "lapper.hpp"
+#include "lapper_set.hpp"
+#include "mapped_file.hpp"
+#include "parallel.hpp"
+
+// Parallel BED/TSV loader.
+//
+// The file is mmapped and cut into one chunk per thread at line boundaries.
+// Each thread parses its chunk in place (contig names are string_views into
+// the mapping, nothing is copied per line) into compact records. A second
+// parallel pass scatters the records straight into per-contig interval
+// buffers at precomputed offsets, which is the input LapperSet is built from.
+//
+// Only the first three columns are read: contig, start, stop. Each interval's
+// val is its 0-based record number in the file. Lines starting with '#',
+// "track" or "browser" and empty lines are skipped.
+namespace bed_detail {
+
+struct Record {
+  uint32_t contig; // chunk-local contig id
+  uint32_t start;
+  uint32_t stop;
+};
+
+struct Chunk {
+  const char *begin;
+  const char *end;
+  std::vector<Record> records;
+  std::vector<std::string_view> contigs;
+  std::string error;
+};
+
+// Parses the decimal digits at p into out and returns a pointer past them,
+// or nullptr if they do not fit a uint32_t: more than 10 digits, or a value
+// above UINT32_MAX. Eight bytes are classified and converted at a time
+// (SWAR) while at least eight bytes remain, falling back to one digit at a
+// time near the end.
+inline const char *parse_uint(const char *p, const char *end, uint32_t &out) {
+  constexpr int max_digits = 10;
+  uint64_t value = 0;
+  int num_digits = 0;
+  bool ended = false;
+  while (!ended && end - p >= 8) {
+    uint64_t chunk;
+    std::memcpy(&chunk, p, 8);
+    uint64_t digits = chunk - 0x3030303030303030ull;
+    // High bit set in every byte that is not '0'..'9'. Borrows and carries
+    // only travel towards later bytes, so the first such byte is exact.
+    uint64_t non_digit =
+        (digits | (digits + 0x7676767676767676ull)) & 0x8080808080808080ull;
+    int len = non_digit ? __builtin_ctzll(non_digit) / 8 : 8;
+    ended = len < 8;
+    if (len == 0)
+      break;
+    if ((num_digits += len) > max_digits)
+      return nullptr;
+    // Left-align the digits so the dropped bytes become leading zeros, then
+    // combine pairs, quads and octets.
+    digits <<= 8 * (8 - len);
+    digits = ((digits & 0x0F0F0F0F0F0F0F0Full) * 2561) >> 8;
+    digits = ((digits & 0x00FF00FF00FF00FFull) * 6553601) >> 16;
+    digits = ((digits & 0x0000FFFF0000FFFFull) * 42949672960001ull) >> 32;
+    static const uint64_t pow10[9] = {1,      10,      100,      1000,    10000,
+                                      100000, 1000000, 10000000, 100000000};
+    value = value * pow10[len] + digits;
+    p += len;
+  }
+  while (!ended && p < end && unsigned(*p - '0') < 10) {
+    if (++num_digits > max_digits)
+      return nullptr;
+    value = value * 10 + (*p++ - '0');
+  }
+  if (value > UINT32_MAX)
+    return nullptr;
+  out = uint32_t(value);
+  return p;
+}
+
+inline bool skip_line(const char *p, const char *end) {
+  auto starts_with = [&](const char *word, size_t n) {
+    return size_t(end - p) >= n && std::memcmp(p, word, n) == 0;
+  };
+  return p == end || *p == '\n' || *p == '\r' || *p == '#' ||
+         starts_with("track", 5) || starts_with("browser", 7);
+}
+
+inline void parse_chunk(Chunk &chunk) {
+  std::unordered_map<std::string_view, uint32_t> ids;
+  const char *p = chunk.begin, *end = chunk.end;
+  while (p < end) {
+    const char *eol = static_cast<const char *>(std::memchr(p, '\n', end - p));
+    if (!eol)
+      eol = end;
+    if (!skip_line(p, eol)) {
+      const char *tab = static_cast<const char *>(std::memchr(p, '\t', eol - p));
+      uint32_t start = 0, stop = 0;
+      bool ok = tab != nullptr;
+      if (ok) {
+        const char *q = parse_uint(tab + 1, eol, start);
+        ok = q && q > tab + 1 && q < eol && *q == '\t';
+        if (ok) {
+          const char *s = q + 1;
+          q = parse_uint(s, eol, stop);
+          ok = q && q > s && (q == eol || *q == '\t' || *q == '\r');
+        }
+      }
+      if (!ok || stop < start) {
+        chunk.error = "malformed BED line: " + std::string(p, eol);
+        return;
+      }
+      std::string_view name(p, tab - p);
+      auto it = ids.emplace(name, uint32_t(chunk.contigs.size())).first;
+      if (it->second == chunk.contigs.size())
+        chunk.contigs.push_back(name);
+      chunk.records.push_back({it->second, start, stop});
+    }
+    p = eol + 1;
+  }
+}
+
+} // namespace bed_detail
+
+// Intervals grouped by contig, contig ids in order of first appearance.
+struct BedData {
+  std::vector<std::string> contig_names;
+  std::vector<std::vector<Interval>> per_contig;
+};
+
+inline BedData read_bed(const std::string &path,
+                        unsigned threads = default_threads()) {
+  using namespace bed_detail;
+  MappedFile file(path);
+  file.advise(MADV_SEQUENTIAL);
+  const char *data = file.data(), *end = data + file.size();
+
+  // Cut at line boundaries: each chunk starts right after a newline.
+  threads = std::max(1u, threads);
+  std::vector<Chunk> chunks(threads);
+  const char *cut = data;
+  for (unsigned t = 0; t < threads; t++) {
+    chunks[t].begin = cut;
+    const char *target = data + file.size() * (t + 1) / threads;
+    if (target < cut)
+      target = cut;
+    const char *nl = target < end ? static_cast<const char *>(
+                                        std::memchr(target, '\n', end - target))
+                                  : nullptr;
+    cut = nl ? nl + 1 : end;
+    if (t == threads - 1)
+      cut = end;
+    chunks[t].end = cut;
+  }
+
+  parallel_chunks(threads, threads, [&](unsigned, size_t begin, size_t stop) {
+    for (size_t t = begin; t < stop; t++)
+      parse_chunk(chunks[t]);
+  });
+  for (const Chunk &c : chunks) {
+    if (!c.error.empty())
+      throw std::runtime_error(path + ": " + c.error);
+  }
+
+  // Global contig ids, then per (chunk, contig) write offsets so the scatter
+  // below needs no synchronization.
+  BedData out;
+  std::unordered_map<std::string_view, uint32_t> ids;
+  std::vector<std::vector<uint32_t>> local_to_global(threads);
+  for (unsigned t = 0; t < threads; t++) {
+    for (std::string_view name : chunks[t].contigs) {
+      auto it = ids.emplace(name, uint32_t(out.contig_names.size())).first;
+      if (it->second == out.contig_names.size())
+        out.contig_names.emplace_back(name);
+      local_to_global[t].push_back(it->second);
+    }
+  }
+  size_t num_contigs = out.contig_names.size();
+  std::vector<std::vector<size_t>> offsets(threads,
+                                           std::vector<size_t>(num_contigs));
+  std::vector<size_t> contig_sizes(num_contigs, 0);
+  std::vector<size_t> record_base(threads, 0);
+  for (unsigned t = 0; t < threads; t++) {
+    std::vector<size_t> local(chunks[t].contigs.size(), 0);
+    for (const Record &r : chunks[t].records)
+      local[r.contig]++;
+    for (size_t c = 0; c < local.size(); c++) {
+      uint32_t g = local_to_global[t][c];
+      offsets[t][g] = contig_sizes[g];
+      contig_sizes[g] += local[c];
+    }
+    if (t + 1 < threads)
+      record_base[t + 1] = record_base[t] + chunks[t].records.size();
+  }
+  out.per_contig.resize(num_contigs);
+  for (size_t g = 0; g < num_contigs; g++)
+    out.per_contig[g].resize(contig_sizes[g]);
+
+  parallel_chunks(threads, threads, [&](unsigned, size_t begin, size_t stop) {
+    for (size_t t = begin; t < stop; t++) {
+      std::vector<size_t> &pos = offsets[t];
+      int32_t val = int32_t(record_base[t]);
+      for (const Record &r : chunks[t].records) {
+        uint32_t g = local_to_global[t][r.contig];
+        out.per_contig[g][pos[g]++] = {r.start, r.stop, val++};
+      }
+    }
+  });
+  return out;
+}
+
+// Loads a BED file straight into a LapperSet keyed by contig name.
+inline LapperSet load_bed(const std::string &path,
+                          unsigned threads = default_threads()) {
+  BedData bed = read_bed(path, threads);
+  return LapperSet(std::move(bed.contig_names), std::move(bed.per_contig),
+                   true, threads);
+}
@@ -0,0 +1,127 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+class Timer {
+    std::chrono::high_resolution_clock::time_point start_time;
+public:
+    void start() {
+        start_time = std::chrono::high_resolution_clock::now();
+    }
+
+    double elapsed_ms() {
+        auto end_time = std::chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time);
+        return duration.count() / 1000.0; // Convert to milliseconds
+    }
+
+    double elapsed_ns() {
+        auto end_time = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double, std::nano>(end_time - start_time).count();
+    }
+};
+
+template<typename Func>
+double benchmark_function(Func&& func, int iterations = 100) {
+    Timer timer;
+    timer.start();
+
+    for (int i = 0; i < iterations; ++i) {
+        func();
+    }
+
+    return timer.elapsed_ms() / iterations;
+}
+
+// Summary of repeated trials, in the unit the samples were taken in.
+struct TrialStats {
+    double median = 0;
+    double min = 0;
+    double p90 = 0;
+    double stddev = 0;
+};
+
+inline TrialStats summarize(std::vector<double> samples) {
+    TrialStats stats;
+    if (samples.empty()) {
+        return stats;
+    }
+    std::sort(samples.begin(), samples.end());
+    size_t n = samples.size();
+    stats.min = samples[0];
+    stats.median = n % 2 ? samples[n / 2] : (samples[n / 2 - 1] + samples[n / 2]) / 2;
+    stats.p90 = samples[std::min(n - 1, (size_t)std::ceil(0.9 * n) - 1)];
+    double mean = 0;
+    for (double s : samples) mean += s;
+    mean /= n;
+    double var = 0;
+    for (double s : samples) var += (s - mean) * (s - mean);
+    stats.stddev = n > 1 ? std::sqrt(var / (n - 1)) : 0;
+    return stats;
+}
+
+// Runs func `warmup` times untimed, then `trials` timed runs. Returns the
+// nanoseconds of each timed run divided by ops_per_trial.
+template<typename Func>
+std::vector<double> run_trials(Func&& func, size_t ops_per_trial, int warmup, int trials) {
+    for (int i = 0; i < warmup; ++i) {
+        func();
+    }
+    std::vector<double> samples;
+    samples.reserve(trials);
+    Timer timer;
+    for (int i = 0; i < trials; ++i) {
+        timer.start();
+        func();
+        samples.push_back(timer.elapsed_ns() / ops_per_trial);
+    }
+    return samples;
+}
+
+// run_trials for adverse conditions: each trial runs ops [0, total) as
+// run_batch(begin, end) in batches of `batch`, calling before_batch() untimed
+// before every batch, e.g. to evict the caches. Returns ns per op per trial.
+template<typename Batch, typename Setup>
+std::vector<double> run_batched_trials(Batch&& run_batch, Setup&& before_batch, size_t total, size_t batch,
+                                       int warmup, int trials) {
+    std::vector<double> samples;
+    samples.reserve(trials);
+    Timer timer;
+    for (int i = 0; i < warmup + trials; ++i) {
+        double ns = 0;
+        for (size_t begin = 0; begin < total; begin += batch) {
+            before_batch();
+            timer.start();
+            run_batch(begin, std::min(total, begin + batch));
+            ns += timer.elapsed_ns();
+        }
+        if (i >= warmup) {
+            samples.push_back(ns / total);
+        }
+    }
+    return samples;
+}
+
+// A /proc/self/status field in kB, e.g. "VmRSS" or "VmHWM"; 0 if missing.
+inline size_t proc_status_kb(const char* field) {
+    std::ifstream status("/proc/self/status");
+    size_t len = std::strlen(field);
+    for (std::string line; std::getline(status, line);) {
+        if (line.compare(0, len, field) == 0 && line.size() > len && line[len] == ':') {
+            return std::stoull(line.substr(len + 1));
+        }
+    }
+    return 0;
+}
+
+// Resets the peak RSS (VmHWM) to the current RSS, so a later reading is the
+// peak since now. False where the kernel does not allow it.
+inline bool reset_peak_rss() {
+    std::ofstream clear("/proc/self/clear_refs");
+    return clear && (clear << "5").flush();
+}
@@ -1,161 +1,773 @@
 #include <iostream>
 #include <vector>
 #include <random>
-#include <chrono>
 #include <algorithm>
 #include <iomanip>
+#include <functional>
+#include <string>
+#include <cstdlib>
+#include <cstdint>
+#include <cmath>
+#include <climits>
+#include <memory>
+#include <thread>
+#include <unistd.h>
+#include "bench_common.hpp"
+#include "cache_pressure.hpp"
 #include "eytzinger.hpp"
+#include "key_distributions.hpp"
+#include "latency.hpp"
+#include "perf_counters.hpp"
+#include "radix_sort.hpp"
+#include "results.hpp"
 
-class Timer {
-    std::chrono::high_resolution_clock::time_point start_time;
-public:
-    void start() {
-        start_time = std::chrono::high_resolution_clock::now();
+// Search benchmark over a geometric sweep of array sizes, so each layout's
+// fall-off at the L1/L2/L3/DRAM boundaries shows up as a step in ns/query.
+//
+//   ./benchmark [--min-n N] [--max-n N] [--growth F] [--keys K]
+//               [--warmup W] [--trials T] [--dist NAME[,NAME...]]
+//               [--no-counters] [--latency] [--group G] [--validate]
+//               [--csv PATH] [--json PATH] [--label NAME]
+//               [--pressure] [--batch B] [--hogs H] [--pressure-mb M]
+//
+// At every n, K keys are drawn from each query distribution
+// (key_distributions.hpp; all of them unless --dist picks some). Every
+// (n, distribution, algorithm) runs W untimed and T timed passes over the
+// same keys and reports median, min, p90 and stddev of ns/query across passes.
+// One further pass runs under hardware counters (perf_counters.hpp), which
+// are reported per query next to the timing when the kernel allows them.
+//
+// --latency replaces the throughput table with per-query latency: after the
+// warm-up, T passes are timed in groups of G queries (default 1) with the
+// TSC and the p50/p99/p99.9/max of the histogram are reported, along with
+// the cost of the timestamps themselves. Each group is one call into the
+// kernel, so batched kernels only reach their vector paths once G is at
+// least their width (8 or 16).
+//
+// --validate times nothing. It checks every registered algorithm against
+// std_lower_bound on every key of every distribution at every n, running
+// dispatched SIMD kernels at each level the CPU supports, then on
+// edge cases: n = 0, 1, 2^k - 1, 2^k, 2^k + 1, duplicate-heavy arrays and
+// INT_MIN/INT_MAX elements and keys. Any disagreement exits with status 1.
+//
+// --csv and --json also write every statistic as one record per
+// (algorithm, n, distribution, threads), with the CPU, compiler and flags
+// (results.hpp) and --label, which names the build in `make matrix`.
+// `make compare BASELINE=old.csv` diffs a fresh run against
+// a saved one with compare_results.
+//
+// Every n also reports what each structure costs to build: wall time, bytes
+// per key kept, and how far peak RSS rose during the build. In throughput
+// mode it then prints, per algorithm, how many queries it takes to earn
+// back that build cost against std::lower_bound on the sorted array, using
+// the first distribution's medians.
+//
+// --pressure measures every layout three ways: warm, as above; cold, with
+// the caches evicted by streaming over M MiB (default twice the LLC) before
+// every batch of B keys (default 1024), eviction untimed; and contended,
+// with H threads (default one per other CPU) streaming over M MiB each
+// while the timed passes run.
+
+struct Options {
+    size_t min_n = 1000;
+    size_t max_n = 1000000000;
+    double growth = 4;
+    size_t num_keys = 60000;
+    int warmup = 2;
+    int trials = 10;
+    bool counters = true;
+    std::vector<std::string> distributions; // empty: all
+    bool latency = false;
+    size_t group = 1;
+    bool validate = false;
+    std::string csv_path;
+    std::string json_path;
+    std::string label = "default";
+    bool pressure = false;
+    size_t batch = 1024;
+    unsigned hogs = std::max(2u, std::thread::hardware_concurrency()) - 1;
+    size_t pressure_mb = 0; // 0: twice the LLC
+};
+
+void print_usage() {
+    std::cout << "usage: benchmark [--min-n N] [--max-n N] [--growth F] [--keys K]"
+                 " [--warmup W] [--trials T]\n"
+                 "                 [--dist NAME[,NAME...]] [--no-counters] [--latency] [--group G]\n"
+                 "                 [--validate] [--csv PATH] [--json PATH] [--label NAME]\n"
+                 "                 [--pressure] [--batch B] [--hogs H] [--pressure-mb M]\n";
+}
+
+Options parse_options(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            print_usage();
+            std::exit(0);
+        }
+        if (arg == "--no-counters") {
+            opt.counters = false;
+            continue;
+        }
+        if (arg == "--latency") {
+            opt.latency = true;
+            continue;
+        }
+        if (arg == "--validate") {
+            opt.validate = true;
+            continue;
+        }
+        if (arg == "--pressure") {
+            opt.pressure = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "missing value for " << arg << "\n";
+            print_usage();
+            std::exit(1);
+        }
+        const char* value = argv[++i];
+        if (arg == "--min-n") {
+            opt.min_n = std::strtoull(value, nullptr, 10);
+        } else if (arg == "--max-n") {
+            opt.max_n = std::strtoull(value, nullptr, 10);
+        } else if (arg == "--growth") {
+            opt.growth = std::strtod(value, nullptr);
+        } else if (arg == "--keys") {
+            opt.num_keys = std::strtoull(value, nullptr, 10);
+        } else if (arg == "--warmup") {
+            opt.warmup = std::atoi(value);
+        } else if (arg == "--trials") {
+            opt.trials = std::atoi(value);
+        } else if (arg == "--batch") {
+            opt.batch = std::strtoull(value, nullptr, 10);
+        } else if (arg == "--hogs") {
+            opt.hogs = (unsigned)std::strtoul(value, nullptr, 10);
+        } else if (arg == "--pressure-mb") {
+            opt.pressure_mb = std::strtoull(value, nullptr, 10);
+        } else if (arg == "--label") {
+            opt.label = value;
+        } else if (arg == "--csv") {
+            opt.csv_path = value;
+        } else if (arg == "--json") {
+            opt.json_path = value;
+        } else if (arg == "--group") {
+            opt.group = std::strtoull(value, nullptr, 10);
+        } else if (arg == "--dist") {
+            std::string list = value;
+            for (size_t pos = 0; pos <= list.size();) {
+                size_t comma = std::min(list.find(',', pos), list.size());
+                opt.distributions.push_back(list.substr(pos, comma - pos));
+                pos = comma + 1;
+            }
+        } else {
+            std::cerr << "unknown option " << arg << "\n";
+            print_usage();
+            std::exit(1);
+        }
     }
-    
-    double elapsed_ms() {
-        auto end_time = std::chrono::high_resolution_clock::now();
-        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time);
-        return duration.count() / 1000.0; // Convert to milliseconds
+    if (opt.min_n == 0 || opt.max_n < opt.min_n || opt.growth <= 1 || opt.num_keys == 0 ||
+        opt.trials <= 0 || opt.warmup < 0 || opt.group == 0 || opt.batch == 0 ||
+        (opt.latency && opt.pressure)) {
+        std::cerr << "invalid options\n";
+        std::exit(1);
     }
+    return opt;
+}
+
+// The registered distributions named in opt, or all of them.
+std::vector<KeyDistribution> selected_distributions(const Options& opt) {
+    std::vector<KeyDistribution> all = key_distributions();
+    if (opt.distributions.empty()) {
+        return all;
+    }
+    std::vector<KeyDistribution> selected;
+    for (const std::string& name : opt.distributions) {
+        auto it = std::find_if(all.begin(), all.end(), [&](const KeyDistribution& d) { return d.name == name; });
+        if (it == all.end()) {
+            std::cerr << "unknown distribution " << name << "; available:";
+            for (const KeyDistribution& d : all) std::cerr << " " << d.name;
+            std::cerr << "\n";
+            std::exit(1);
+        }
+        selected.push_back(*it);
+    }
+    return selected;
+}
+
+// Array sizes from min_n to max_n, each growth times the previous, always
+// ending at max_n itself so the largest size asked for is measured.
+std::vector<size_t> sweep_sizes(const Options& opt) {
+    std::vector<size_t> sizes;
+    for (double n = opt.min_n; n <= opt.max_n * 1.0000001; n *= opt.growth) {
+        sizes.push_back((size_t)std::llround(n));
+    }
+    if (!sizes.empty() && sizes.back() < opt.max_n) {
+        sizes.push_back(opt.max_n);
+    }
+    return sizes;
+}
+
+// The sorted array and every layout built from it, for one n.
+struct SearchStructures {
+    std::vector<int> sorted;
+    Eytzinger eytz;
+
+    explicit SearchStructures(std::vector<int> elements) : sorted(std::move(elements)), eytz(sorted) {}
 };
 
-template<typename Func>
-double benchmark_function(Func&& func, int iterations = 100) {
+// What a kernel's result indexes: the sorted array, or the Eytzinger array
+// (0 for "past the end").
+enum class ResultIndex { sorted, eytzinger };
+
+// The structure a kernel searches, for build-cost reporting.
+const char* structure_name(ResultIndex result) {
+    return result == ResultIndex::eytzinger ? "Eytzinger" : "sorted array";
+}
+
+// Build cost of one search structure. peak_rss_mib is how far peak RSS rose
+// above the RSS before the build, or negative if it could not be measured.
+struct BuildReport {
+    std::string structure;
+    double ms = 0;
+    double bytes_per_key = 0;
+    double peak_rss_mib = -1;
+};
+
+// Times build(), which returns the bytes the structure keeps.
+template<typename Build>
+BuildReport measure_build(const std::string& structure, size_t n, Build&& build) {
+    BuildReport report;
+    report.structure = structure;
+    bool peak_ok = reset_peak_rss();
+    size_t rss_before = proc_status_kb("VmRSS");
     Timer timer;
     timer.start();
-    
-    for (int i = 0; i < iterations; ++i) {
-        func();
-    }
-    
-    return timer.elapsed_ms() / iterations;
-}
-
-int main() {
-    const int num_elements = 6000000;  // Same as Mojo version
-    const int num_keys = 60000;
-    const int benchmark_iterations = 10;
-    
-    std::cout << "Generating " << num_elements << " elements and " << num_keys << " search keys...\n";
-    
-    // Generate random sorted elements
-    std::vector<int> elements(num_elements);
-    std::random_device rd;
+    size_t bytes = build();
+    report.ms = timer.elapsed_ms();
+    report.bytes_per_key = n ? (double)bytes / n : 0;
+    size_t peak = proc_status_kb("VmHWM");
+    if (peak_ok && peak > 0) {
+        report.peak_rss_mib = (peak > rss_before ? peak - rss_before : 0) / 1024.0;
+    }
+    return report;
+}
+
+void print_build_reports(const std::vector<BuildReport>& builds) {
+    std::cout << "\n" << std::setw(34) << "Structure" << std::setw(12) << "build ms" << std::setw(12)
+              << "bytes/key" << std::setw(15) << "peak RSS +MiB" << "\n";
+    std::cout << std::string(73, '-') << "\n";
+    for (const BuildReport& b : builds) {
+        std::cout << std::setw(34) << b.structure << std::fixed << std::setprecision(3) << std::setw(12) << b.ms
+                  << std::setprecision(2) << std::setw(12) << b.bytes_per_key << std::setw(15);
+        if (b.peak_rss_mib < 0) {
+            std::cout << "n/a";
+        } else {
+            std::cout << b.peak_rss_mib;
+        }
+        std::cout << std::endl;
+    }
+}
+
+// One search kernel. run() searches every key and returns a checksum of the
+// results so the searches cannot be optimized away; it is what gets timed.
+// run_into() writes each key's result to out instead, through the same code
+// path as run() on the same keys, for validation. Kernels that dispatch on
+// SIMD level use the level passed to run_into(); the others ignore it.
+struct SearchAlgorithm {
+    std::string name;
+    std::function<long long(SearchStructures&, const int* keys, size_t count)> run;
+    std::function<void(SearchStructures&, const int* keys, int* out, size_t count, SimdLevel level)> run_into;
+    ResultIndex result = ResultIndex::sorted;
+    bool dispatched = false;
+};
+
+// A kernel that answers one key at a time with search(s, key).
+template<typename Search>
+SearchAlgorithm per_key(const std::string& name, Search search, ResultIndex result = ResultIndex::sorted) {
+    return {name,
+            [search](SearchStructures& s, const int* keys, size_t count) {
+                long long sum = 0;
+                for (size_t i = 0; i < count; ++i) sum += search(s, keys[i]);
+                return sum;
+            },
+            [search](SearchStructures& s, const int* keys, int* out, size_t count, SimdLevel) {
+                for (size_t i = 0; i < count; ++i) out[i] = search(s, keys[i]);
+            },
+            result};
+}
+
+// Keys go to the batched kernel this many at a time, so it sees full vectors.
+constexpr size_t search_batch = 256;
+
+std::vector<SearchAlgorithm> search_algorithms() {
+    auto batched_into = [](SearchStructures& s, const int* keys, int* out, size_t count, SimdLevel level) {
+        for (size_t i = 0; i < count; i += search_batch) {
+            s.eytz.lower_bound_batch(keys + i, out + i, std::min(search_batch, count - i), level);
+        }
+    };
+    return {
+        per_key("Naive binary search", [](SearchStructures& s, int key) { return naive_binary_search(s.sorted, key); }),
+        per_key("std::lower_bound", [](SearchStructures& s, int key) { return std_lower_bound(s.sorted, key); }),
+        per_key("Eytzinger original", [](SearchStructures& s, int key) { return s.eytz.lower_bound_original(key); },
+                ResultIndex::eytzinger),
+        per_key("Eytzinger fixed iterations",
+                [](SearchStructures& s, int key) { return s.eytz.lower_bound_fixed_iter(key); },
+                ResultIndex::eytzinger),
+        per_key("Eytzinger with prefetch",
+                [](SearchStructures& s, int key) { return s.eytz.lower_bound_prefetch(key); },
+                ResultIndex::eytzinger),
+        per_key("Eytzinger fixed iter + prefetch",
+                [](SearchStructures& s, int key) { return s.eytz.lower_bound_fixed_iter_prefetch(key); },
+                ResultIndex::eytzinger),
+        // Dispatched at startup to the scalar, AVX2 or AVX-512 kernel.
+        {"Eytzinger batched (dispatched)", [](SearchStructures& s, const int* keys, size_t count) {
+            long long sum = 0;
+            int out[search_batch];
+            for (size_t i = 0; i < count; i += search_batch) {
+                size_t m = std::min(search_batch, count - i);
+                s.eytz.lower_bound_batch(keys + i, out, m);
+                for (size_t j = 0; j < m; ++j) sum += out[j];
+            }
+            return sum;
+        }, batched_into, ResultIndex::eytzinger, true},
+    };
+}
+
+// Checks every algorithm against std_lower_bound on every key, running each
+// over the whole key array so batched kernels take their vector paths, and
+// dispatched kernels once per SIMD level this host supports. Prints each
+// disagreement (up to a limit) and returns the number of them.
+size_t validate_structures(const std::vector<SearchAlgorithm>& algorithms, SearchStructures& s,
+                           const std::vector<int>& keys, const std::string& context, size_t& checked) {
+    std::vector<int> eytz_positions = s.eytz.sorted_positions();
+    std::vector<long long> expected(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i) expected[i] = std_lower_bound(s.sorted, keys[i]);
+    std::vector<int> out(keys.size());
+    size_t failures = 0;
+    for (const SearchAlgorithm& algo : algorithms) {
+        int top = algo.dispatched ? (int)detect_simd_level() : (int)SimdLevel::scalar;
+        for (int level = (int)SimdLevel::scalar; level <= top; ++level) {
+            std::fill(out.begin(), out.end(), -1);
+            algo.run_into(s, keys.data(), out.data(), keys.size(), (SimdLevel)level);
+            checked += keys.size();
+            for (size_t i = 0; i < keys.size(); ++i) {
+                long long index = out[i];
+                if (algo.result == ResultIndex::eytzinger) {
+                    // An out-of-range Eytzinger index reports as -1, a mismatch.
+                    bool valid = index >= 0 && index < (long long)eytz_positions.size();
+                    index = valid ? eytz_positions[index] : -1;
+                }
+                if (index != expected[i] && failures++ < 20) {
+                    std::cerr << "MISMATCH " << algo.name;
+                    if (algo.dispatched) std::cerr << " [" << simd_level_name((SimdLevel)level) << "]";
+                    std::cerr << " (" << context << ", n = " << s.sorted.size() << ", key " << keys[i]
+                              << "): got " << index << ", expected " << expected[i] << "\n";
+                }
+            }
+        }
+    }
+    return failures;
+}
+
+// Edge-case arrays: each size around powers of two, filled with wide
+// distinct-ish values, heavy duplicates, or values pinned at INT_MIN/INT_MAX.
+// Keys are every element, its neighbours, the extremes and random values.
+size_t validate_edge_cases(const std::vector<SearchAlgorithm>& algorithms, std::mt19937& gen,
+                           size_t& checked) {
+    std::vector<size_t> sizes = {0, 1, 2, 3, 5};
+    for (size_t k = 2; k <= 16; ++k) {
+        sizes.insert(sizes.end(), {(size_t(1) << k) - 1, size_t(1) << k, (size_t(1) << k) + 1});
+    }
+    const char* fills[] = {"wide", "duplicates", "extremes"};
+    size_t failures = 0;
+    for (size_t n : sizes) {
+        for (const char* fill : fills) {
+            std::vector<int> elements(n);
+            std::uniform_int_distribution<int> wide(INT_MIN / 2, INT_MAX / 2);
+            std::uniform_int_distribution<int> few(0, (int)n / 8);
+            std::uniform_int_distribution<int> coin(0, 3);
+            for (int& e : elements) {
+                if (fill == fills[0]) {
+                    e = wide(gen);
+                } else if (fill == fills[1]) {
+                    e = few(gen);
+                } else {
+                    int c = coin(gen);
+                    e = c == 0 ? INT_MIN : c == 1 ? INT_MAX : wide(gen);
+                }
+            }
+            std::sort(elements.begin(), elements.end());
+
+            std::vector<int> keys = {INT_MIN, INT_MIN + 1, -1, 0, 1, INT_MAX - 1, INT_MAX};
+            for (int e : elements) {
+                keys.push_back(e);
+                if (e != INT_MIN) keys.push_back(e - 1);
+                if (e != INT_MAX) keys.push_back(e + 1);
+            }
+            for (int i = 0; i < 64; ++i) keys.push_back(wide(gen));
+
+            SearchStructures structures(std::move(elements));
+            failures += validate_structures(algorithms, structures, keys, fill, checked);
+        }
+    }
+    return failures;
+}
+
+// Rough peak bytes for one n: the elements, a std::sort copy, the radix sort
+// buffer and the Eytzinger array.
+bool fits_in_memory(size_t n) {
+    double phys = (double)sysconf(_SC_PHYS_PAGES) * sysconf(_SC_PAGE_SIZE);
+    return 16.0 * n < phys / 2;
+}
+
+void print_pressure_header() {
+    std::cout << std::setw(34) << "Algorithm" << std::setw(11) << "warm" << std::setw(11) << "cold"
+              << std::setw(11) << "contended" << std::setw(11) << "cold/warm" << std::setw(11) << "cont/warm"
+              << "\n";
+    std::cout << std::setw(34) << "" << std::setw(33) << "(median ns/query)" << "\n";
+    std::cout << std::string(89, '-') << std::endl;
+}
+
+void print_stats_header(const PerfCounters* counters) {
+    std::cout << std::setw(34) << "Algorithm" << std::setw(11) << "median" << std::setw(11) << "min"
+              << std::setw(11) << "p90" << std::setw(11) << "stddev" << std::setw(10) << "Relative";
+    size_t width = 88;
+    if (counters) {
+        for (int e = 0; e < PerfCounters::num_events; ++e) {
+            std::cout << std::setw(11) << PerfCounters::name(e);
+        }
+        std::cout << std::setw(7) << "IPC";
+        width += 11 * PerfCounters::num_events + 7;
+    }
+    std::cout << "\n" << std::setw(34) << "" << std::setw(44) << "(ns/query)";
+    if (counters) {
+        std::cout << std::setw(10 + 11 * PerfCounters::num_events) << "(per query)";
+    }
+    std::cout << "\n" << std::string(width, '-') << std::endl;
+}
+
+void print_stats_row(const std::string& name, const TrialStats& s, double baseline_median,
+                     const PerfCounters::Reading* reading, size_t queries) {
+    std::cout << std::setw(34) << name << std::fixed << std::setprecision(2)
+              << std::setw(11) << s.median << std::setw(11) << s.min << std::setw(11) << s.p90
+              << std::setw(11) << s.stddev << std::setw(9) << baseline_median / s.median << "x";
+    if (reading) {
+        const double* v = reading->values;
+        for (int e = 0; e < PerfCounters::num_events; ++e) {
+            if (v[e] < 0) {
+                std::cout << std::setw(11) << "-";
+            } else {
+                std::cout << std::setw(11) << v[e] / queries;
+            }
+        }
+        if (v[PerfCounters::cycles] > 0 && v[PerfCounters::instructions] >= 0) {
+            std::cout << std::setw(7) << v[PerfCounters::instructions] / v[PerfCounters::cycles];
+        } else {
+            std::cout << std::setw(7) << "-";
+        }
+    }
+    std::cout << std::endl;
+}
+
+// Queries after which each algorithm's extra build cost, beyond the sorted
+// array std::lower_bound needs, is paid back by its faster queries.
+void print_break_even(const std::vector<SearchAlgorithm>& algorithms, const std::vector<double>& medians,
+                      const std::vector<BuildReport>& builds, const std::string& dist_name, size_t n,
+                      ResultWriter& results) {
+    double std_median = 0;
+    for (size_t a = 0; a < algorithms.size(); ++a) {
+        if (algorithms[a].name == "std::lower_bound") std_median = medians[a];
+    }
+    std::cout << "\nBreak-even vs std::lower_bound (keys: " << dist_name << ")\n";
+    std::cout << std::setw(34) << "Algorithm" << std::setw(16) << "extra build ms" << std::setw(16)
+              << "saved ns/query" << std::setw(20) << "queries to recoup" << "\n";
+    std::cout << std::string(86, '-') << "\n";
+    for (size_t a = 0; a < algorithms.size(); ++a) {
+        std::string structure = structure_name(algorithms[a].result);
+        double extra_ms = 0;
+        for (const BuildReport& b : builds) {
+            if (b.structure == structure && structure != structure_name(ResultIndex::sorted)) extra_ms = b.ms;
+        }
+        double saved = std_median - medians[a];
+        std::cout << std::setw(34) << algorithms[a].name << std::fixed << std::setprecision(3) << std::setw(16)
+                  << extra_ms << std::setprecision(2) << std::setw(16) << saved << std::setw(20);
+        if (algorithms[a].name == "std::lower_bound") {
+            std::cout << "-";
+        } else if (saved > 0) {
+            double queries = extra_ms * 1e6 / saved;
+            std::cout << std::setprecision(0) << queries;
+            results.add({algorithms[a].name, n, dist_name, 1, 1, "break_even_queries", queries});
+        } else {
+            std::cout << "never";
+        }
+        std::cout << std::endl;
+    }
+}
+
+int main(int argc, char** argv) {
+    Options opt = parse_options(argc, argv);
+    std::vector<SearchAlgorithm> algorithms = search_algorithms();
+    std::vector<KeyDistribution> distributions = selected_distributions(opt);
     std::mt19937 gen(42); // Same seed as Mojo version
-    std::uniform_int_distribution<> elem_dist(0, num_elements);
-    
-    for (int& elem : elements) {
-        elem = elem_dist(gen);
-    }
-    std::sort(elements.begin(), elements.end());
-    
-    // Generate search keys
-    std::vector<int> keys(num_keys);
-    std::uniform_int_distribution<> key_dist(0, num_keys);
-    for (int& key : keys) {
-        key = key_dist(gen);
-    }
-    
-    // Create Eytzinger structure
-    std::cout << "Building Eytzinger structure...\n";
-    Eytzinger eytz(elements);
-    
-    std::cout << "\nRunning benchmarks...\n";
-    std::cout << std::setw(40) << "Algorithm" << std::setw(15) << "Time (ms)" << std::setw(12) << "Relative" << std::endl;
-    std::cout << std::string(67, '-') << std::endl;
-    
-    // Benchmark naive binary search
-    double naive_time = benchmark_function([&]() {
-        volatile int dummy = 0;
-        for (int key : keys) {
-            dummy += naive_binary_search(elements, key);
-        }
-    }, benchmark_iterations);
-    
-    std::cout << std::setw(40) << "Naive binary search" 
-              << std::setw(15) << std::fixed << std::setprecision(3) << naive_time
-              << std::setw(12) << "1.00x" << std::endl;
-    
-    // Benchmark std::lower_bound
-    double std_time = benchmark_function([&]() {
-        volatile int dummy = 0;
-        for (int key : keys) {
-            dummy += std_lower_bound(elements, key);
-        }
-    }, benchmark_iterations);
-    
-    std::cout << std::setw(40) << "std::lower_bound" 
-              << std::setw(15) << std::fixed << std::setprecision(3) << std_time
-              << std::setw(12) << std::fixed << std::setprecision(2) << (naive_time / std_time) << "x" << std::endl;
-    
-    // Benchmark Eytzinger original
-    double eytz_orig_time = benchmark_function([&]() {
-        volatile int dummy = 0;
-        for (int key : keys) {
-            dummy += eytz.lower_bound_original(key);
-        }
-    }, benchmark_iterations);
-    
-    std::cout << std::setw(40) << "Eytzinger original" 
-              << std::setw(15) << std::fixed << std::setprecision(3) << eytz_orig_time
-              << std::setw(12) << std::fixed << std::setprecision(2) << (naive_time / eytz_orig_time) << "x" << std::endl;
-    
-    // Benchmark Eytzinger fixed iterations
-    double eytz_fixed_time = benchmark_function([&]() {
-        volatile int dummy = 0;
-        for (int key : keys) {
-            dummy += eytz.lower_bound_fixed_iter(key);
-        }
-    }, benchmark_iterations);
-    
-    std::cout << std::setw(40) << "Eytzinger fixed iterations" 
-              << std::setw(15) << std::fixed << std::setprecision(3) << eytz_fixed_time
-              << std::setw(12) << std::fixed << std::setprecision(2) << (naive_time / eytz_fixed_time) << "x" << std::endl;
-    
-    // Benchmark Eytzinger with prefetch
-    double eytz_prefetch_time = benchmark_function([&]() {
-        volatile int dummy = 0;
-        for (int key : keys) {
-            dummy += eytz.lower_bound_prefetch(key);
-        }
-    }, benchmark_iterations);
-    
-    std::cout << std::setw(40) << "Eytzinger with prefetch" 
-              << std::setw(15) << std::fixed << std::setprecision(3) << eytz_prefetch_time
-              << std::setw(12) << std::fixed << std::setprecision(2) << (naive_time / eytz_prefetch_time) << "x" << std::endl;
-    
-    // Benchmark Eytzinger fixed iterations with prefetch
-    double eytz_fixed_prefetch_time = benchmark_function([&]() {
-        volatile int dummy = 0;
-        for (int key : keys) {
-            dummy += eytz.lower_bound_fixed_iter_prefetch(key);
-        }
-    }, benchmark_iterations);
-    
-    std::cout << std::setw(40) << "Eytzinger fixed iter + prefetch" 
-              << std::setw(15) << std::fixed << std::setprecision(3) << eytz_fixed_prefetch_time
-              << std::setw(12) << std::fixed << std::setprecision(2) << (naive_time / eytz_fixed_prefetch_time) << "x" << std::endl;
-    
-    // Verify correctness by comparing a few results
-    std::cout << "\nVerifying correctness (first 10 searches):\n";
-    std::cout << std::setw(8) << "Key" << std::setw(10) << "Naive" << std::setw(10) << "Std" 
-              << std::setw(12) << "Eytz Orig" << std::setw(12) << "Eytz Fixed" << std::endl;
-    std::cout << std::string(52, '-') << std::endl;
-    
-    for (int i = 0; i < std::min(10, num_keys); ++i) {
-        int key = keys[i];
-        int naive_result = naive_binary_search(elements, key);
-        int std_result = std_lower_bound(elements, key);
-        int eytz_orig_result = eytz.lower_bound_original(key);
-        int eytz_fixed_result = eytz.lower_bound_fixed_iter(key);
-        
-        std::cout << std::setw(8) << key 
-                  << std::setw(10) << naive_result
-                  << std::setw(10) << std_result
-                  << std::setw(12) << eytz_orig_result
-                  << std::setw(12) << eytz_fixed_result << std::endl;
-    }
-    
+
+    PerfCounters perf;
+    PerfCounters* counters = opt.counters && !opt.latency && !opt.pressure && perf.available() ? &perf : nullptr;
+    TscClock clock;
+    ResultWriter results;
+    results.set_metadata("label", opt.label);
+    results.set_metadata("simd", simd_level_name(simd_level()));
+    results.set_metadata("mode", opt.latency ? "latency" : opt.pressure ? "pressure" : "throughput");
+    results.set_metadata("keys", std::to_string(opt.num_keys));
+    results.set_metadata("warmup", std::to_string(opt.warmup));
+    results.set_metadata("counters", counters ? "yes" : "no");
+    // Search kernels run on one thread.
+    const unsigned threads = 1;
+
+    if (opt.label != "default") {
+        std::cout << "Build: " << opt.label << "\n";
+    }
+    std::cout << "SIMD kernels: " << simd_level_name(simd_level()) << " (cpu supports "
+              << simd_level_name(detect_simd_level()) << "; set LAPPER_SIMD to override)\n";
+    std::cout << "Sweeping n from " << opt.min_n << " to " << opt.max_n << " (x" << opt.growth << "), "
+              << opt.num_keys << " keys per distribution, ";
+    if (opt.validate) {
+        std::cout << "validating only\n";
+    } else if (opt.latency) {
+        std::cout << opt.warmup << " warm-up + " << opt.trials << " trials\n";
+        LatencyHistogram overhead = timer_overhead();
+        std::cout << "Latency mode, groups of " << opt.group << " queries; TSC at " << std::fixed
+                  << std::setprecision(3) << clock.ticks_per_ns << " ticks/ns, timestamp overhead p50 "
+                  << std::setprecision(1) << clock.to_ns(overhead.percentile(50)) << " ns, p99 "
+                  << clock.to_ns(overhead.percentile(99)) << " ns per group\n";
+    } else {
+        std::cout << opt.warmup << " warm-up + " << opt.trials << " trials\n";
+    }
+    size_t pressure_bytes = opt.pressure_mb ? opt.pressure_mb << 20 : 2 * llc_bytes();
+    std::unique_ptr<CacheEvictor> evictor;
+    if (opt.pressure && !opt.validate) {
+        evictor = std::make_unique<CacheEvictor>(pressure_bytes);
+        std::cout << "Pressure mode: evicting " << (pressure_bytes >> 20) << " MiB before every " << opt.batch
+                  << " keys; " << opt.hogs << " bandwidth hog(s) of " << (pressure_bytes >> 20) << " MiB each\n";
+        results.set_metadata("pressure_mb", std::to_string(pressure_bytes >> 20));
+        results.set_metadata("batch", std::to_string(opt.batch));
+        results.set_metadata("hogs", std::to_string(opt.hogs));
+    }
+    if (!opt.validate && !opt.latency && !opt.pressure && opt.counters && !counters) {
+        std::cout << "Hardware counters unavailable (no PMU, or perf_event_paranoid too strict); "
+                     "reporting timing only\n";
+    }
+
+    std::vector<size_t> sizes;
+    for (size_t n : sweep_sizes(opt)) {
+        if (fits_in_memory(n)) {
+            sizes.push_back(n);
+        } else {
+            std::cout << "n = " << n << ": skipped, needs more than half of physical memory\n";
+        }
+    }
+
+    size_t validation_failures = 0, validation_checks = 0;
+    for (size_t n : sizes) {
+        std::vector<int> elements(n);
+        std::uniform_int_distribution<> elem_dist(0, (int)std::min<size_t>(n, INT32_MAX));
+        for (int& elem : elements) {
+            elem = elem_dist(gen);
+        }
+        std::vector<int> std_sorted = elements;
+        Timer sort_timer;
+        sort_timer.start();
+        std::sort(std_sorted.begin(), std_sorted.end());
+        double std_sort_ms = sort_timer.elapsed_ms();
+        std::vector<BuildReport> builds;
+        builds.push_back(measure_build(structure_name(ResultIndex::sorted), n, [&]() {
+            radix_sort(elements);
+            return elements.size() * sizeof(int);
+        }));
+        double radix_sort_ms = builds.back().ms;
+        if (opt.validate && elements != std_sorted) {
+            std::cerr << "MISMATCH radix_sort disagrees with std::sort at n = " << n << "\n";
+            ++validation_failures;
+        }
+        std::vector<int>().swap(std_sorted);
+        // The sorted array moves in for free, so this is the Eytzinger build.
+        std::unique_ptr<SearchStructures> owned;
+        builds.push_back(measure_build(structure_name(ResultIndex::eytzinger), n, [&]() {
+            owned = std::make_unique<SearchStructures>(std::move(elements));
+            return (owned->eytz.size() + 1) * sizeof(int);
+        }));
+        SearchStructures& structures = *owned;
+        for (const BuildReport& b : builds) {
+            results.add({b.structure, n, "build", threads, 1, "build_ms", b.ms});
+            results.add({b.structure, n, "build", threads, 1, "bytes_per_key", b.bytes_per_key});
+            if (b.peak_rss_mib >= 0) {
+                results.add({b.structure, n, "build", threads, 1, "peak_rss_mib", b.peak_rss_mib});
+            }
+        }
+        results.add({"std::sort", n, "build", threads, 1, "ms", std_sort_ms});
+
+        std::cout << "\nn = " << n << " (" << std::fixed << std::setprecision(1)
+                  << n * sizeof(int) / 1048576.0 << " MiB); sorting: std::sort " << std::setprecision(3)
+                  << std_sort_ms << " ms, radix_sort " << radix_sort_ms << " ms\n";
+        std::vector<int> keys;
+        // Throughput medians of the first distribution, per algorithm.
+        std::vector<double> first_medians;
+        for (const KeyDistribution& dist : distributions) {
+            keys = dist.generate(structures.sorted, opt.num_keys, gen);
+            if (opt.validate) {
+                validation_failures += validate_structures(algorithms, structures, keys, dist.name, validation_checks);
+                continue;
+            }
+            std::cout << "\nkeys: " << dist.name << "\n";
+            if (opt.latency) {
+                print_latency_header(34);
+                for (const SearchAlgorithm& algo : algorithms) {
+                    volatile long long sink = 0;
+                    for (int i = 0; i < opt.warmup; ++i) {
+                        sink += algo.run(structures, keys.data(), keys.size());
+                    }
+                    LatencyHistogram hist;
+                    for (int t = 0; t < opt.trials; ++t) {
+                        record_group_latency(hist, [&](size_t begin, size_t end) {
+                            sink += algo.run(structures, keys.data() + begin, end - begin);
+                        }, keys.size(), opt.group);
+                    }
+                    print_latency_row(algo.name, 34, hist, clock);
+                    const std::pair<const char*, double> percentiles[] = {
+                        {"p50_ns", 50}, {"p99_ns", 99}, {"p99.9_ns", 99.9}, {"max_ns", 100}};
+                    for (const auto& [statistic, p] : percentiles) {
+                        results.add({algo.name, n, dist.name, threads, opt.trials, statistic,
+                                     clock.to_ns(hist.percentile(p))});
+                    }
+                }
+                continue;
+            }
+            if (opt.pressure) {
+                std::vector<TrialStats> warm, cold, contended;
+                volatile long long sink = 0;
+                for (const SearchAlgorithm& algo : algorithms) {
+                    auto pass = [&]() { sink += algo.run(structures, keys.data(), keys.size()); };
+                    warm.push_back(summarize(run_trials(pass, keys.size(), opt.warmup, opt.trials)));
+                    cold.push_back(summarize(run_batched_trials(
+                        [&](size_t begin, size_t end) { sink += algo.run(structures, keys.data() + begin, end - begin); },
+                        [&]() { evictor->evict(); }, keys.size(), opt.batch, opt.warmup, opt.trials)));
+                }
+                BandwidthHog hog;
+                unsigned own_cpus = hog.start(opt.hogs, pressure_bytes);
+                for (const SearchAlgorithm& algo : algorithms) {
+                    auto pass = [&]() { sink += algo.run(structures, keys.data(), keys.size()); };
+                    contended.push_back(summarize(run_trials(pass, keys.size(), opt.warmup, opt.trials)));
+                }
+                hog.stop();
+                if (own_cpus < opt.hogs) {
+                    std::cout << "(only " << own_cpus << " of " << opt.hogs
+                              << " hogs had a CPU of their own; the rest time-share with the benchmark)\n";
+                }
+                print_pressure_header();
+                for (size_t a = 0; a < algorithms.size(); ++a) {
+                    std::cout << std::setw(34) << algorithms[a].name << std::fixed << std::setprecision(2)
+                              << std::setw(11) << warm[a].median << std::setw(11) << cold[a].median
+                              << std::setw(11) << contended[a].median << std::setw(10)
+                              << cold[a].median / warm[a].median << "x" << std::setw(10)
+                              << contended[a].median / warm[a].median << "x" << std::endl;
+                    const std::pair<const char*, const TrialStats*> conditions[] = {
+                        {"warm", &warm[a]}, {"cold", &cold[a]}, {"contended", &contended[a]}};
+                    for (const auto& [condition, stats] : conditions) {
+                        std::string prefix = condition;
+                        results.add({algorithms[a].name, n, dist.name, threads, opt.trials, prefix + "_median_ns",
+                                     stats->median});
+                        results.add({algorithms[a].name, n, dist.name, threads, opt.trials, prefix + "_stddev_ns",
+                                     stats->stddev});
+                    }
+                }
+                continue;
+            }
+            print_stats_header(counters);
+            double baseline = 0;
+            for (const SearchAlgorithm& algo : algorithms) {
+                volatile long long sink = 0;
+                auto pass = [&]() { sink += algo.run(structures, keys.data(), keys.size()); };
+                TrialStats stats = summarize(run_trials(pass, keys.size(), opt.warmup, opt.trials));
+                if (baseline == 0) {
+                    baseline = stats.median;
+                }
+                if (&dist == &distributions.front()) {
+                    first_medians.push_back(stats.median);
+                }
+                // Counted separately so the ioctls stay out of the timed passes.
+                PerfCounters::Reading reading;
+                if (counters) {
+                    counters->start();
+                    pass();
+                    reading = counters->stop();
+                }
+                print_stats_row(algo.name, stats, baseline, counters ? &reading : nullptr, keys.size());
+                results.add({algo.name, n, dist.name, threads, opt.trials, "median_ns", stats.median});
+                results.add({algo.name, n, dist.name, threads, opt.trials, "min_ns", stats.min});
+                results.add({algo.name, n, dist.name, threads, opt.trials, "p90_ns", stats.p90});
+                results.add({algo.name, n, dist.name, threads, opt.trials, "stddev_ns", stats.stddev});
+                for (int e = 0; counters && e < PerfCounters::num_events; ++e) {
+                    if (reading.values[e] >= 0) {
+                        results.add({algo.name, n, dist.name, threads, 1,
+                                     std::string(PerfCounters::name(e)) + "_per_query",
+                                     reading.values[e] / keys.size()});
+                    }
+                }
+            }
+        }
+        if (!opt.validate) {
+            print_build_reports(builds);
+        }
+        if (!first_medians.empty()) {
+            print_break_even(algorithms, first_medians, builds, distributions.front().name, n, results);
+        }
+        if (opt.validate || n != sizes.back()) {
+            continue;
+        }
+
+        // Verify correctness by comparing a few results of the last
+        // distribution at the largest n.
+        std::cout << "\nVerifying correctness (first 10 searches, n = " << n << "):\n";
+        std::cout << std::setw(8) << "Key" << std::setw(10) << "Naive" << std::setw(10) << "Std"
+                  << std::setw(12) << "Eytz Orig" << std::setw(12) << "Eytz Fixed" << std::endl;
+        std::cout << std::string(52, '-') << std::endl;
+
+        for (size_t i = 0; i < std::min<size_t>(10, keys.size()); ++i) {
+            int key = keys[i];
+            int naive_result = naive_binary_search(structures.sorted, key);
+            int std_result = std_lower_bound(structures.sorted, key);
+            int eytz_orig_result = structures.eytz.lower_bound_original(key);
+            int eytz_fixed_result = structures.eytz.lower_bound_fixed_iter(key);
+
+            std::cout << std::setw(8) << key
+                      << std::setw(10) << naive_result
+                      << std::setw(10) << std_result
+                      << std::setw(12) << eytz_orig_result
+                      << std::setw(12) << eytz_fixed_result << std::endl;
+        }
+    }
+
+    if (opt.validate) {
+        validation_failures += validate_edge_cases(algorithms, gen, validation_checks);
+        if (validation_failures > 0) {
+            std::cerr << "\nVALIDATION FAILED: " << validation_failures << " of " << validation_checks
+                      << " checks disagree with std_lower_bound\n";
+            return 1;
+        }
+        std::cout << "\nValidation passed: " << validation_checks << " checks across " << algorithms.size()
+                  << " algorithms agree with std_lower_bound (dispatched kernels at every SIMD level up to "
+                  << simd_level_name(detect_simd_level()) << ")\n";
+        return 0;
+    }
+
+    if (!opt.csv_path.empty()) {
+        results.write_csv(opt.csv_path);
+        std::cout << "\nWrote " << opt.csv_path << "\n";
+    }
+    if (!opt.json_path.empty()) {
+        results.write_json(opt.json_path);
+        std::cout << "\nWrote " << opt.json_path << "\n";
+    }
+
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,124 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+// Adverse cache conditions for the benchmarks: evicting the caches between
+// batches of queries, and memory-bandwidth hogs on other cores, so layouts
+// can be compared when the index is not the only thing in cache.
+
+// Last-level cache size in bytes, or 32 MiB when it cannot be determined.
+inline size_t llc_bytes() {
+    size_t best = 0;
+    int best_level = 0;
+    for (int index = 0; index < 8; ++index) {
+        std::string dir = "/sys/devices/system/cpu/cpu0/cache/index" + std::to_string(index) + "/";
+        std::ifstream level_in(dir + "level"), size_in(dir + "size");
+        int level;
+        std::string size;
+        if (!(level_in >> level) || !(size_in >> size) || level < best_level) continue;
+        size_t value = std::stoull(size);
+        char unit = size.back();
+        best = unit == 'K' ? value << 10 : unit == 'M' ? value << 20 : value;
+        best_level = level;
+    }
+    return best ? best : size_t(32) << 20;
+}
+
+// Streams over a buffer larger than the LLC, touching every line, so
+// whatever was cached before is gone. Each line is written as well as read,
+// which also forces the previous dirty contents out.
+class CacheEvictor {
+    std::vector<uint64_t> buffer;
+    uint64_t round = 0;
+
+public:
+    explicit CacheEvictor(size_t bytes = 2 * llc_bytes()) : buffer(bytes / sizeof(uint64_t), 1) {}
+
+    size_t bytes() const { return buffer.size() * sizeof(uint64_t); }
+
+    void evict() {
+        ++round;
+        for (size_t i = 0; i < buffer.size(); i += 64 / sizeof(uint64_t)) {
+            buffer[i] += round;
+        }
+    }
+};
+
+// Threads that stream reads and writes over private buffers larger than the
+// LLC until stopped. Each is pinned to a CPU other than the caller's when
+// the machine has one to spare.
+class BandwidthHog {
+    std::atomic<bool> running{false};
+    std::vector<std::thread> threads;
+    bool pinned_self = false;
+    cpu_set_t saved_affinity;
+
+public:
+    BandwidthHog() = default;
+    BandwidthHog(const BandwidthHog&) = delete;
+    BandwidthHog& operator=(const BandwidthHog&) = delete;
+    ~BandwidthHog() { stop(); }
+
+    // Starts n hogs with `bytes` each. Returns how many got a CPU of their
+    // own, i.e. did not share the caller's.
+    unsigned start(unsigned n, size_t bytes = 2 * llc_bytes()) {
+        stop();
+        running = true;
+        int self = sched_getcpu();
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        sched_getaffinity(0, sizeof(allowed), &allowed);
+        std::vector<int> others;
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &allowed) && cpu != self) others.push_back(cpu);
+        }
+        // Keep the measured thread where it is so the hogs stay off it.
+        if (self >= 0 && !others.empty()) {
+            pthread_getaffinity_np(pthread_self(), sizeof(saved_affinity), &saved_affinity);
+            pinned_self = true;
+            cpu_set_t mine;
+            CPU_ZERO(&mine);
+            CPU_SET(self, &mine);
+            pthread_setaffinity_np(pthread_self(), sizeof(mine), &mine);
+        }
+        for (unsigned t = 0; t < n; ++t) {
+            threads.emplace_back([this, bytes] {
+                std::vector<uint64_t> buffer(bytes / sizeof(uint64_t), 1);
+                uint64_t sum = 0;
+                while (running.load(std::memory_order_relaxed)) {
+                    for (size_t i = 0; i < buffer.size(); i += 8) {
+                        sum += buffer[i];
+                        buffer[i] = sum;
+                    }
+                }
+            });
+            if (!others.empty()) {
+                cpu_set_t cpus;
+                CPU_ZERO(&cpus);
+                CPU_SET(others[t % others.size()], &cpus);
+                pthread_setaffinity_np(threads.back().native_handle(), sizeof(cpus), &cpus);
+            }
+        }
+        return (unsigned)std::min<size_t>(n, others.size());
+    }
+
+    void stop() {
+        running = false;
+        for (std::thread& t : threads) t.join();
+        threads.clear();
+        if (pinned_self) {
+            pthread_setaffinity_np(pthread_self(), sizeof(saved_affinity), &saved_affinity);
+            pinned_self = false;
+        }
+    }
+};
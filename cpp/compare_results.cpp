@@ -0,0 +1,115 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "results.hpp"
+
+// Compares two CSV files written by `benchmark --csv` and flags changes in
+// median ns/query that exceed the run-to-run noise.
+//
+//   ./compare_results BASELINE.csv CURRENT.csv [--sigma K] [--min-pct P]
+//
+// The noise threshold for each (algorithm, n, distribution, threads) is
+// K times the combined trial stddev of both runs, and never less than P
+// percent of the baseline median (defaults K = 3, P = 2). Exits with status
+// 1 if anything regressed past its threshold.
+
+using ResultKey = std::tuple<std::string, size_t, std::string, unsigned>;
+
+struct Measurement {
+    double median = NAN;
+    double stddev = NAN;
+};
+
+std::map<ResultKey, Measurement> load(const std::string& path, std::map<std::string, std::string>& meta) {
+    std::map<ResultKey, Measurement> out;
+    for (const ResultRecord& r : read_results_csv(path, &meta)) {
+        ResultKey key{r.algorithm, r.n, r.distribution, r.threads};
+        if (r.statistic == "median_ns") {
+            out[key].median = r.value;
+        } else if (r.statistic == "stddev_ns") {
+            out[key].stddev = r.value;
+        }
+    }
+    return out;
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> paths;
+    double sigma = 3;
+    double min_pct = 2;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if ((arg == "--sigma" || arg == "--min-pct") && i + 1 < argc) {
+            (arg == "--sigma" ? sigma : min_pct) = std::strtod(argv[++i], nullptr);
+        } else {
+            paths.push_back(arg);
+        }
+    }
+    if (paths.size() != 2) {
+        std::cerr << "usage: compare_results BASELINE.csv CURRENT.csv [--sigma K] [--min-pct P]\n";
+        return 2;
+    }
+
+    std::map<std::string, std::string> base_meta, cur_meta;
+    std::map<ResultKey, Measurement> base, cur;
+    try {
+        base = load(paths[0], base_meta);
+        cur = load(paths[1], cur_meta);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 2;
+    }
+
+    for (const char* field : {"label", "cpu", "compiler", "flags"}) {
+        std::string b = base_meta.count(field) ? base_meta[field] : "-";
+        std::string c = cur_meta.count(field) ? cur_meta[field] : "-";
+        std::cout << std::setw(10) << field << ": " << b;
+        if (b != c) std::cout << "  ->  " << c;
+        std::cout << "\n";
+    }
+    if (base_meta["cpu"] != cur_meta["cpu"]) {
+        std::cout << "warning: runs are from different CPUs\n";
+    }
+
+    std::cout << "\n" << std::setw(34) << "Algorithm" << std::setw(12) << "n" << std::setw(11) << "keys"
+              << std::setw(11) << "base" << std::setw(11) << "current" << std::setw(10) << "change"
+              << std::setw(10) << "noise" << "\n";
+    std::cout << std::string(99, '-') << "\n";
+    int regressions = 0, improvements = 0, compared = 0;
+    for (const auto& [key, b] : base) {
+        auto it = cur.find(key);
+        if (it == cur.end() || std::isnan(b.median) || std::isnan(it->second.median)) continue;
+        const Measurement& c = it->second;
+        double noise = sigma * std::sqrt((std::isnan(b.stddev) ? 0 : b.stddev * b.stddev) +
+                                         (std::isnan(c.stddev) ? 0 : c.stddev * c.stddev));
+        noise = std::max(noise, b.median * min_pct / 100);
+        double delta = c.median - b.median;
+        ++compared;
+        const char* verdict = "";
+        if (delta > noise) {
+            verdict = "  REGRESSION";
+            ++regressions;
+        } else if (delta < -noise) {
+            verdict = "  faster";
+            ++improvements;
+        }
+        std::cout << std::setw(34) << std::get<0>(key) << std::setw(12) << std::get<1>(key) << std::setw(11)
+                  << std::get<2>(key) << std::fixed << std::setprecision(2) << std::setw(11) << b.median
+                  << std::setw(11) << c.median << std::setw(9) << 100 * delta / b.median << "%" << std::setw(9)
+                  << 100 * noise / b.median << "%" << verdict << "\n";
+    }
+
+    std::cout << "\n" << compared << " compared, " << regressions << " regressed, " << improvements
+              << " faster beyond noise\n";
+    if (compared == 0) {
+        std::cerr << "no measurements in common; were both runs made with the same options?\n";
+        return 2;
+    }
+    return regressions > 0 ? 1 : 0;
+}
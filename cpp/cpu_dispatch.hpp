@@ -0,0 +1,61 @@
+#pragma once
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// Runtime choice of SIMD kernels, so one binary built without -march can run
+// AVX2 or AVX-512 code where the host has it. Kernels are compiled once per
+// level with target attributes; callers pick one through simd_level().
+//
+// simd_level() is decided once, from cpuid, and can be lowered for
+// benchmarking with LAPPER_SIMD=scalar|avx2|avx512. Asking for a level the
+// host lacks falls back to the best supported one, with a warning.
+enum class SimdLevel { scalar = 0, avx2 = 1, avx512 = 2 };
+
+inline const char *simd_level_name(SimdLevel level) {
+  switch (level) {
+  case SimdLevel::avx512:
+    return "avx512";
+  case SimdLevel::avx2:
+    return "avx2";
+  default:
+    return "scalar";
+  }
+}
+
+inline SimdLevel detect_simd_level() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f"))
+    return SimdLevel::avx512;
+  if (__builtin_cpu_supports("avx2"))
+    return SimdLevel::avx2;
+#endif
+  return SimdLevel::scalar;
+}
+
+inline SimdLevel simd_level() {
+  static const SimdLevel level = [] {
+    SimdLevel best = detect_simd_level();
+    const char *env = std::getenv("LAPPER_SIMD");
+    if (!env || !*env)
+      return best;
+    SimdLevel wanted = best;
+    if (std::strcmp(env, "scalar") == 0)
+      wanted = SimdLevel::scalar;
+    else if (std::strcmp(env, "avx2") == 0)
+      wanted = SimdLevel::avx2;
+    else if (std::strcmp(env, "avx512") == 0)
+      wanted = SimdLevel::avx512;
+    else
+      std::fprintf(stderr, "LAPPER_SIMD=%s not recognized; using %s\n", env,
+                   simd_level_name(best));
+    if (wanted > best) {
+      std::fprintf(stderr, "LAPPER_SIMD=%s not supported here; using %s\n",
+                   env, simd_level_name(best));
+      wanted = best;
+    }
+    return wanted;
+  }();
+  return level;
+}
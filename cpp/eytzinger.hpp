@@ -1,8 +1,15 @@
 #pragma once
 #include <algorithm>
 #include <cmath>
+#include <cstddef>
 #include <vector>
 
+#include "cpu_dispatch.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
 // Portable implementation of std::__lg
 inline int lg(int n) {
   if (n == 0)
@@ -10,6 +17,118 @@ inline int lg(int n) {
   return 31 - __builtin_clz(n);
 }
 
+// Batched fixed-iteration descent: several keys walk the tree in lockstep,
+// so their cache misses overlap. One kernel per SIMD level; the AVX ones
+// gather t[k] for 8 or 16 keys at once and keep k in 32-bit lanes.
+namespace eytzinger_detail {
+
+constexpr size_t scalar_lanes = 8;
+
+inline void batch_scalar(const int *t, int n, int iters, const int *keys,
+                         int *out, size_t count) {
+  size_t i = 0;
+  for (; i + scalar_lanes <= count; i += scalar_lanes) {
+    long k[scalar_lanes];
+    for (size_t l = 0; l < scalar_lanes; l++)
+      k[l] = 1;
+    for (int j = 0; j < iters; j++)
+      for (size_t l = 0; l < scalar_lanes; l++)
+        k[l] = 2 * k[l] + (t[k[l]] < keys[i + l]);
+    for (size_t l = 0; l < scalar_lanes; l++) {
+      const int *loc = k[l] <= n ? t + k[l] : t;
+      k[l] = 2 * k[l] + ((k[l] > n) | (*loc < keys[i + l]));
+      out[i + l] = k[l] >> __builtin_ffsl(~k[l]);
+    }
+  }
+  for (; i < count; i++) {
+    long k = 1;
+    for (int j = 0; j < iters; j++)
+      k = 2 * k + (t[k] < keys[i]);
+    const int *loc = k <= n ? t + k : t;
+    k = 2 * k + ((k > n) | (*loc < keys[i]));
+    out[i] = k >> __builtin_ffsl(~k);
+  }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2"))) inline void
+batch_avx2(const int *t, int n, int iters, const int *keys, int *out,
+           size_t count) {
+  const __m256i one = _mm256_set1_epi32(1), nv = _mm256_set1_epi32(n);
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256i x = _mm256_loadu_si256((const __m256i *)(keys + i));
+    __m256i k = one;
+    // The comparison is -1 where t[k] < x, so subtracting it adds the bit.
+    for (int j = 0; j < iters; j++) {
+      __m256i v = _mm256_i32gather_epi32(t, k, 4);
+      k = _mm256_sub_epi32(_mm256_add_epi32(k, k), _mm256_cmpgt_epi32(x, v));
+    }
+    __m256i missing = _mm256_cmpgt_epi32(k, nv);
+    __m256i v = _mm256_i32gather_epi32(t, _mm256_andnot_si256(missing, k), 4);
+    __m256i right = _mm256_or_si256(missing, _mm256_cmpgt_epi32(x, v));
+    k = _mm256_sub_epi32(_mm256_add_epi32(k, k), right);
+    alignas(32) int ks[8];
+    _mm256_store_si256((__m256i *)ks, k);
+    for (int l = 0; l < 8; l++)
+      out[i + l] = ks[l] >> __builtin_ffs(~ks[l]);
+  }
+  batch_scalar(t, n, iters, keys + i, out + i, count - i);
+}
+
+__attribute__((target("avx512f"))) inline void
+batch_avx512(const int *t, int n, int iters, const int *keys, int *out,
+             size_t count) {
+  const __m512i one = _mm512_set1_epi32(1), nv = _mm512_set1_epi32(n);
+  size_t i = 0;
+  for (; i + 16 <= count; i += 16) {
+    __m512i x = _mm512_loadu_si512(keys + i);
+    __m512i k = one;
+    for (int j = 0; j < iters; j++) {
+      __m512i v = _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), 0xFFFF,
+                                              k, t, 4);
+      __m512i k2 = _mm512_add_epi32(k, k);
+      k = _mm512_mask_add_epi32(k2, _mm512_cmpgt_epi32_mask(x, v), k2, one);
+    }
+    __mmask16 missing = _mm512_cmpgt_epi32_mask(k, nv);
+    __m512i v = _mm512_mask_i32gather_epi32(_mm512_setzero_si512(),
+                                            (__mmask16)~missing, k, t, 4);
+    __mmask16 right = missing | _mm512_cmpgt_epi32_mask(x, v);
+    __m512i k2 = _mm512_add_epi32(k, k);
+    k = _mm512_mask_add_epi32(k2, right, k2, one);
+    alignas(64) int ks[16];
+    _mm512_store_si512(ks, k);
+    for (int l = 0; l < 16; l++)
+      out[i + l] = ks[l] >> __builtin_ffs(~ks[l]);
+  }
+  batch_scalar(t, n, iters, keys + i, out + i, count - i);
+}
+#endif
+
+// The SIMD kernels' 32-bit k reaches 4 * (n + 1).
+constexpr int max_simd_n = (1 << 29) - 2;
+
+// level must be one the host supports, i.e. at most detect_simd_level().
+inline void lower_bound_batch(const int *t, int n, int iters, const int *keys,
+                              int *out, size_t count,
+                              SimdLevel level = simd_level()) {
+#if defined(__x86_64__) || defined(__i386__)
+  if (n <= max_simd_n) {
+    switch (level) {
+    case SimdLevel::avx512:
+      return batch_avx512(t, n, iters, keys, out, count);
+    case SimdLevel::avx2:
+      return batch_avx2(t, n, iters, keys, out, count);
+    default:
+      break;
+    }
+  }
+#endif
+  batch_scalar(t, n, iters, keys, out, count);
+}
+
+} // namespace eytzinger_detail
+
 class Eytzinger {
 private:
   std::vector<int> t;
@@ -28,7 +147,7 @@ private:
 public:
   Eytzinger(std::vector<int> &sorted_array) : n(sorted_array.size()) {
     t.resize(n + 1);
-    t[0] = -1; // sentinel value less than any element
+    t[0] = -1; // read in place of missing last-level nodes
 
     eytzinger(sorted_array);
     iters = lg(n + 1);
@@ -53,9 +172,10 @@ public:
       k = 2 * k + (t[k] < x);
     }
 
-    // Final comparison with predication
+    // Final comparison with predication; a missing last-level node counts
+    // as less than x whatever the sentinel holds.
     int *loc = (k <= n ? t.data() + k : t.data());
-    k = 2 * k + (*loc < x);
+    k = 2 * k + ((k > n) | (*loc < x));
 
     // Restore actual index
     k >>= __builtin_ffs(~k);
@@ -83,12 +203,40 @@ public:
     }
 
     int *loc = (k <= n ? t.data() + k : t.data());
-    k = 2 * k + (*loc < x);
+    k = 2 * k + ((k > n) | (*loc < x));
 
     k >>= __builtin_ffs(~k);
     return k;
   }
 
+  // lower_bound_fixed_iter for keys[0, count) into out, using the widest
+  // kernel simd_level() allows, or the kernel for an explicit level.
+  void lower_bound_batch(const int *keys, int *out, size_t count,
+                         SimdLevel level = simd_level()) const {
+    eytzinger_detail::lower_bound_batch(t.data(), n, iters, keys, out, count,
+                                        level);
+  }
+
+  // Sorted-array position of every Eytzinger index, with index 0 (no
+  // element >= x) mapped to n.
+  std::vector<int> sorted_positions() const {
+    std::vector<int> pos(n + 1);
+    pos[0] = n;
+    int rank = 0;
+    // In-order walk of the implicit tree.
+    int k = 1;
+    while (true) {
+      while (k <= n)
+        k = 2 * k;
+      k >>= __builtin_ffs(~k);
+      if (k == 0)
+        break;
+      pos[k] = rank++;
+      k = 2 * k + 1;
+    }
+    return pos;
+  }
+
   // Get the actual value (for comparison with C++ literature)
   int get_value(int index) { return (index < t.size()) ? t[index] : -1; }
 
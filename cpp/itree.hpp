@@ -0,0 +1,131 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "lapper.hpp"
+
+// Implicit augmented interval tree, after Heng Li's cgranges.
+//
+// Intervals are kept sorted by start, exactly as in Lapper, and that array is
+// read as a complete binary tree: leaves sit at even indices, a node at level
+// k has its lowest k bits set and its children k-1 levels down at x -/+
+// 2^(k-1). The max stop of each subtree is stored next to the node in the
+// max_ends column, which lets a query prune whole subtrees regardless of how
+// deeply the intervals nest. There is no global max_len.
+class ImplicitIntervalTree {
+private:
+  std::vector<uint32_t> starts;
+  std::vector<uint32_t> stops;
+  std::vector<int32_t> vals;
+  std::vector<uint32_t> max_ends;
+  int max_level = 0;
+
+  // Subtrees at or below this level are scanned linearly, the tree walk
+  // costs more than it saves on a handful of intervals.
+  static constexpr int scan_level = 3;
+
+  void fill(std::vector<Interval> &intervals) {
+    sort_intervals(intervals);
+    size_t n = intervals.size();
+    starts.resize(n);
+    stops.resize(n);
+    vals.resize(n);
+    max_ends.resize(n);
+    for (size_t i = 0; i < n; i++) {
+      starts[i] = intervals[i].start;
+      stops[i] = intervals[i].stop;
+      vals[i] = intervals[i].val;
+      max_ends[i] = stops[i];
+    }
+    if (n == 0)
+      return;
+
+    // Bottom up, level by level. `last` tracks the max stop of the rightmost
+    // existing subtree at the current level; it stands in for right children
+    // that fall past the end of the array.
+    size_t last_i = 0;
+    uint32_t last = max_ends[0];
+    for (size_t i = 0; i < n; i += 2) {
+      last_i = i;
+      last = max_ends[i];
+    }
+    int k = 1;
+    for (; (size_t(1) << k) <= n; k++) {
+      size_t x = size_t(1) << (k - 1);
+      size_t i0 = (x << 1) - 1;
+      size_t step = x << 2;
+      for (size_t i = i0; i < n; i += step) {
+        uint32_t left = max_ends[i - x];
+        uint32_t right = i + x < n ? max_ends[i + x] : last;
+        max_ends[i] = std::max({stops[i], left, right});
+      }
+      last_i = (last_i >> k & 1) ? last_i - x : last_i + x;
+      if (last_i < n && max_ends[last_i] > last)
+        last = max_ends[last_i];
+    }
+    max_level = k - 1;
+  }
+
+  // Visits every overlapping row, in no particular order.
+  template <typename F> void visit(uint32_t start, uint32_t stop, F &&f) const {
+    size_t n = starts.size();
+    if (n == 0)
+      return;
+
+    struct Frame {
+      int k;
+      size_t x;
+      bool left_done;
+    };
+    Frame stack[64];
+    int top = 0;
+    stack[top++] = {max_level, (size_t(1) << max_level) - 1, false};
+    while (top > 0) {
+      Frame z = stack[--top];
+      if (z.k <= scan_level) {
+        size_t i0 = z.x >> z.k << z.k;
+        size_t i1 = std::min(n, i0 + (size_t(1) << (z.k + 1)) - 1);
+        for (size_t i = i0; i < i1 && starts[i] < stop; i++) {
+          if (stops[i] > start)
+            f(i);
+        }
+      } else if (!z.left_done) {
+        size_t y = z.x - (size_t(1) << (z.k - 1));
+        stack[top++] = {z.k, z.x, true};
+        if (y >= n || max_ends[y] > start)
+          stack[top++] = {z.k - 1, y, false};
+      } else if (z.x < n && starts[z.x] < stop) {
+        if (stops[z.x] > start)
+          f(z.x);
+        stack[top++] = {z.k - 1, z.x + (size_t(1) << (z.k - 1)), false};
+      }
+    }
+  }
+
+public:
+  // Takes the same input as Lapper; intervals are sorted internally.
+  explicit ImplicitIntervalTree(std::vector<Interval> intervals) {
+    fill(intervals);
+  }
+
+  // Appends every interval overlapping [start, stop) to results. Results are
+  // not ordered.
+  void find(uint32_t start, uint32_t stop,
+            std::vector<Interval> &results) const {
+    visit(start, stop, [&](size_t i) {
+      results.push_back({starts[i], stops[i], vals[i]});
+    });
+  }
+
+  size_t count(uint32_t start, uint32_t stop) const {
+    size_t n = 0;
+    visit(start, stop, [&](size_t) { n++; });
+    return n;
+  }
+
+  size_t size() const { return starts.size(); }
+
+  int depth() const { return max_level; }
+};
@@ -0,0 +1,178 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "lapper.hpp"
+#include "parallel.hpp"
+
+// All overlapping pairs between two Lappers, bedtools-intersect style.
+//
+// Both indexes are swept together in start order. Each side keeps an active
+// set of rows that have started but not yet stopped, as a min-heap on stop.
+// When a row from one side comes up, rows of the other side's active set that
+// stop at or before its start are dropped, and every remaining one overlaps
+// it. The work is linear in the input plus the number of pairs, with no
+// binary search per query.
+//
+// Rows are positions in the views' columns, so view.starts[row] etc. give
+// the interval and view.vals[row] its value or payload row id.
+namespace join_detail {
+
+constexpr size_t chunk_size = 4096;
+
+// Rows of one side that are still open at the sweep position, as a min-heap
+// on stop. Stops are kept next to the row ids so heap updates stay local.
+template <typename Coord, typename Val> struct ActiveSet {
+  struct Entry {
+    Coord stop;
+    uint32_t row;
+    // Heap order: the entry that stops first is on top.
+    bool operator<(const Entry &other) const { return stop > other.stop; }
+  };
+
+  const BasicLapperView<Coord, Val> &v;
+  std::vector<Entry> rows;
+
+  void push(uint32_t row) {
+    rows.push_back({v.stops[row], row});
+    std::push_heap(rows.begin(), rows.end());
+  }
+
+  void evict(Coord position) {
+    while (!rows.empty() && rows.front().stop <= position) {
+      std::pop_heap(rows.begin(), rows.end());
+      rows.pop_back();
+    }
+  }
+
+  // Rows that started before lo and are still open at lo.
+  void seed(Coord lo) {
+    for (size_t k = 0; k < v.num_classes; k++) {
+      const BasicLengthClass<Coord> &c = v.classes[k];
+      size_t i = c.offset + lower_bound_index(v.starts + c.offset, c.length,
+                                              saturating_sub(lo, c.max_len));
+      for (; i < c.offset + c.length && v.starts[i] < lo; i++) {
+        if (v.stops[i] > lo)
+          rows.push_back({v.stops[i], uint32_t(i)});
+      }
+    }
+    std::make_heap(rows.begin(), rows.end());
+  }
+};
+
+// Emits every pair where the later-starting row of the two starts in
+// [lo, hi), or at or after lo when unbounded. Ties go to a before b.
+template <typename Coord, typename Val, typename Sink>
+void sweep(const BasicLapperView<Coord, Val> &a,
+           const BasicLapperView<Coord, Val> &b, Coord lo, Coord hi,
+           bool unbounded, Sink &sink) {
+  ActiveSet<Coord, Val> active_a{a, {}}, active_b{b, {}};
+  active_a.seed(lo);
+  active_b.seed(lo);
+  StartOrderCursor<Coord, Val> cursor_a(a, lo, hi, unbounded);
+  StartOrderCursor<Coord, Val> cursor_b(b, lo, hi, unbounded);
+
+  uint32_t buf_a[chunk_size], buf_b[chunk_size];
+  size_t n = 0;
+  auto flush = [&]() {
+    if (n > 0)
+      sink(static_cast<const uint32_t *>(buf_a),
+           static_cast<const uint32_t *>(buf_b), n);
+    n = 0;
+  };
+
+  size_t ra = cursor_a.peek(), rb = cursor_b.peek();
+  while (ra != SIZE_MAX || rb != SIZE_MAX) {
+    bool from_a =
+        rb == SIZE_MAX || (ra != SIZE_MAX && a.starts[ra] <= b.starts[rb]);
+    const BasicLapperView<Coord, Val> &v = from_a ? a : b;
+    ActiveSet<Coord, Val> &mine = from_a ? active_a : active_b;
+    ActiveSet<Coord, Val> &other = from_a ? active_b : active_a;
+    size_t row = from_a ? ra : rb;
+    Coord start = v.starts[row], stop = v.stops[row];
+
+    other.evict(start);
+    // Active rows start at or before start and stop after it, so they all
+    // overlap a non-empty row. An empty row overlaps only those that started
+    // strictly before it.
+    for (const auto &e : other.rows) {
+      if (stop > start || other.v.starts[e.row] < start) {
+        buf_a[n] = from_a ? uint32_t(row) : e.row;
+        buf_b[n] = from_a ? e.row : uint32_t(row);
+        if (++n == chunk_size)
+          flush();
+      }
+    }
+    if (stop > start)
+      mine.push(uint32_t(row));
+
+    if (from_a) {
+      cursor_a.advance(row);
+      ra = cursor_a.peek();
+    } else {
+      cursor_b.advance(row);
+      rb = cursor_b.peek();
+    }
+  }
+  flush();
+}
+
+} // namespace join_detail
+
+// Pairs collected by a join, as two parallel row columns.
+struct JoinPairs {
+  std::vector<uint32_t> rows_a;
+  std::vector<uint32_t> rows_b;
+
+  void operator()(const uint32_t *a, const uint32_t *b, size_t n) {
+    rows_a.insert(rows_a.end(), a, a + n);
+    rows_b.insert(rows_b.end(), b, b + n);
+  }
+
+  size_t size() const { return rows_a.size(); }
+};
+
+// Calls sink(rows_a, rows_b, n) with every overlapping (row of a, row of b)
+// pair, up to join_detail::chunk_size pairs per call. Pairs come in sweep
+// order: grouped by whichever row of the pair starts later.
+template <typename Coord, typename Val, typename Sink>
+void join(const BasicLapperView<Coord, Val> &a,
+          const BasicLapperView<Coord, Val> &b, Sink &&sink) {
+  join_detail::sweep(a, b, Coord(0), Coord(0), true, sink);
+}
+
+// Parallel join. The coordinate space is cut at quantiles of the larger
+// side's starts and each thread sweeps one range, seeded with the rows still
+// open at its left edge. Chunks are concatenated in range order, so the
+// result holds the same pairs as join.
+template <typename Coord, typename Val>
+JoinPairs join_pairs(const BasicLapperView<Coord, Val> &a,
+                     const BasicLapperView<Coord, Val> &b,
+                     unsigned threads = default_threads()) {
+  const BasicLapperView<Coord, Val> &big = a.length >= b.length ? a : b;
+  threads = std::max(1u, std::min<unsigned>(threads, big.length / 1024 + 1));
+  std::vector<Coord> cuts(threads + 1, 0);
+  for (unsigned t = 1; t < threads; t++)
+    cuts[t] = big.starts_sorted[big.length * t / threads];
+
+  std::vector<JoinPairs> parts(threads);
+  parallel_chunks(threads, threads, [&](unsigned, size_t begin, size_t end) {
+    for (size_t t = begin; t < end; t++)
+      join_detail::sweep(a, b, cuts[t], cuts[t + 1], t == threads - 1,
+                         parts[t]);
+  });
+
+  if (threads == 1)
+    return std::move(parts[0]);
+  JoinPairs out;
+  size_t total = 0;
+  for (const JoinPairs &p : parts)
+    total += p.size();
+  out.rows_a.reserve(total);
+  out.rows_b.reserve(total);
+  for (const JoinPairs &p : parts)
+    out(p.rows_a.data(), p.rows_b.data(), p.size());
+  return out;
+}
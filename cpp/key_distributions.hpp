@@ -0,0 +1,128 @@
+#pragma once
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+// Query key generators for the search benchmarks. Each one draws keys
+// relative to the sorted array being searched, so every n is exercised over
+// its whole range rather than a fixed prefix.
+//
+//   uniform    uniform over [min, max] of the array
+//   zipfian    array elements by Zipf rank (s = 0.99), hot ranks scattered
+//   clustered  ascending runs of 64 keys, each covering ~64 neighbours
+//   miss       uniform above the maximum, so every search falls off the end
+//   duplicate  only 16 distinct element values, repeated
+
+// Zipf sampler over ranks 1..n by rejection-inversion (Hörmann and
+// Derflinger), O(1) per sample and no O(n) table.
+class ZipfSampler {
+    double s;
+    double n;
+    double h_integral_x1;
+    double h_integral_n;
+    double threshold;
+
+    static double helper1(double x) {
+        return std::abs(x) > 1e-8 ? std::log1p(x) / x : 1 - x * (0.5 - x * (1.0 / 3 - 0.25 * x));
+    }
+
+    static double helper2(double x) {
+        return std::abs(x) > 1e-8 ? std::expm1(x) / x : 1 + x * 0.5 * (1 + x * (1.0 / 3) * (1 + 0.25 * x));
+    }
+
+    double h(double x) const { return std::exp(-s * std::log(x)); }
+
+    double h_integral(double x) const {
+        double log_x = std::log(x);
+        return helper2((1 - s) * log_x) * log_x;
+    }
+
+    double h_integral_inverse(double x) const {
+        double t = std::max(-1.0, x * (1 - s));
+        return std::exp(helper1(t) * x);
+    }
+
+public:
+    ZipfSampler(uint64_t n, double s)
+        : s(s), n((double)n), h_integral_x1(h_integral(1.5) - 1), h_integral_n(h_integral(n + 0.5)),
+          threshold(2 - h_integral_inverse(h_integral(2.5) - h(2))) {}
+
+    template<typename Gen>
+    uint64_t operator()(Gen& gen) {
+        std::uniform_real_distribution<double> unit(0, 1);
+        while (true) {
+            double u = h_integral_n + unit(gen) * (h_integral_x1 - h_integral_n);
+            double x = h_integral_inverse(u);
+            double k = std::min(n, std::max(1.0, std::floor(x + 0.5)));
+            if (k - x <= threshold || u >= h_integral(k + 0.5) - h(k)) {
+                return (uint64_t)k;
+            }
+        }
+    }
+};
+
+struct KeyDistribution {
+    std::string name;
+    std::function<std::vector<int>(const std::vector<int>& sorted, size_t count, std::mt19937& gen)> generate;
+};
+
+inline std::vector<KeyDistribution> key_distributions() {
+    return {
+        {"uniform", [](const std::vector<int>& sorted, size_t count, std::mt19937& gen) {
+            std::vector<int> keys(count);
+            std::uniform_int_distribution<int> dist(sorted.front(), sorted.back());
+            for (int& key : keys) key = dist(gen);
+            return keys;
+        }},
+        {"zipfian", [](const std::vector<int>& sorted, size_t count, std::mt19937& gen) {
+            std::vector<int> keys(count);
+            ZipfSampler zipf(sorted.size(), 0.99);
+            for (int& key : keys) {
+                // Scatter ranks so the hot keys are not all at the front.
+                uint64_t rank = zipf(gen) - 1;
+                key = sorted[(rank * 0x9E3779B97F4A7C15ull >> 17) % sorted.size()];
+            }
+            return keys;
+        }},
+        {"clustered", [](const std::vector<int>& sorted, size_t count, std::mt19937& gen) {
+            const size_t run = 64;
+            std::vector<int> keys;
+            keys.reserve(count);
+            int64_t lo = sorted.front(), hi = sorted.back();
+            int64_t gap = std::max<int64_t>(1, (hi - lo) / (int64_t)sorted.size());
+            std::uniform_int_distribution<int64_t> base_dist(lo, hi);
+            std::uniform_int_distribution<int64_t> step_dist(0, 2 * gap);
+            while (keys.size() < count) {
+                int64_t key = base_dist(gen);
+                for (size_t j = 0; j < run && keys.size() < count; ++j) {
+                    keys.push_back((int)std::min(key, hi));
+                    key += step_dist(gen);
+                }
+            }
+            return keys;
+        }},
+        {"miss", [](const std::vector<int>& sorted, size_t count, std::mt19937& gen) {
+            std::vector<int> keys(count);
+            int lo = sorted.back() == INT_MAX ? INT_MAX : sorted.back() + 1;
+            int64_t span = std::max<int64_t>(1, (int64_t)sorted.back() - sorted.front());
+            int hi = (int)std::min<int64_t>(INT_MAX, lo + span);
+            std::uniform_int_distribution<int> dist(lo, hi);
+            for (int& key : keys) key = dist(gen);
+            return keys;
+        }},
+        {"duplicate", [](const std::vector<int>& sorted, size_t count, std::mt19937& gen) {
+            std::vector<int> values(16);
+            std::uniform_int_distribution<size_t> pick(0, sorted.size() - 1);
+            for (int& value : values) value = sorted[pick(gen)];
+            std::vector<int> keys(count);
+            std::uniform_int_distribution<size_t> which(0, values.size() - 1);
+            for (int& key : keys) key = values[which(gen)];
+            return keys;
+        }},
+    };
+}
@@ -0,0 +1,748 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "radix_sort.hpp"
+
+// Half-open interval [start, stop) with an associated value.
+//
+// Overlap uses strict inequality, same as the Mojo Lapper: [10,20) and
+// [20,30) touch but do not overlap.
+//
+// Coord must be an unsigned integer type; Interval (32-bit coordinates) is
+// the common case, Interval64 covers genomes over 4 Gb and timestamps.
+template <typename Coord, typename Val> struct BasicInterval {
+  static_assert(std::is_unsigned<Coord>::value,
+                "interval coordinates must be unsigned");
+  Coord start;
+  Coord stop;
+  Val val;
+
+  static bool overlap(Coord a_start, Coord a_stop, Coord b_start,
+                      Coord b_stop) {
+    return a_start < b_stop && a_stop > b_start;
+  }
+
+  bool overlap(Coord qstart, Coord qstop) const {
+    return overlap(start, stop, qstart, qstop);
+  }
+
+  // Ordered by start, then stop. The value does not take part in ordering.
+  bool operator<(const BasicInterval &other) const {
+    return start < other.start || (start == other.start && stop < other.stop);
+  }
+
+  bool operator==(const BasicInterval &other) const {
+    return start == other.start && stop == other.stop;
+  }
+};
+
+using Interval = BasicInterval<uint32_t, int32_t>;
+using Interval64 = BasicInterval<uint64_t, int64_t>;
+
+// Sorts intervals by (start, stop) with a radix sort. Equal intervals keep
+// their input order. Input that is already sorted, such as coordinate-sorted
+// BED, is detected in one linear pass and left as is.
+//
+// 32-bit coordinates pack into one 64-bit key and take a single radix sort;
+// wider ones are sorted by stop and then, stably, by start.
+template <typename Coord, typename Val>
+void sort_intervals(std::vector<BasicInterval<Coord, Val>> &intervals,
+                    unsigned threads = default_threads()) {
+  if (std::is_sorted(intervals.begin(), intervals.end()))
+    return;
+  size_t n = intervals.size();
+  std::vector<uint32_t> perm;
+  if constexpr (sizeof(Coord) <= 4) {
+    std::vector<uint64_t> keys(n);
+    for (size_t i = 0; i < n; i++)
+      keys[i] = uint64_t(intervals[i].start) << 32 | intervals[i].stop;
+    perm = radix_argsort(keys, threads);
+  } else {
+    std::vector<Coord> keys(n);
+    for (size_t i = 0; i < n; i++)
+      keys[i] = intervals[i].stop;
+    perm = radix_argsort(keys, threads);
+    for (size_t i = 0; i < n; i++)
+      keys[i] = intervals[perm[i]].start;
+    radix_sort(keys, perm, threads);
+  }
+  std::vector<BasicInterval<Coord, Val>> sorted(n);
+  for (size_t i = 0; i < n; i++)
+    sorted[i] = intervals[perm[i]];
+  intervals.swap(sorted);
+}
+
+template <typename Coord> Coord saturating_sub(Coord a, Coord b) {
+  return a > b ? a - b : 0;
+}
+
+// Index of the first element of the sorted a[0, n) that is >= key, or > key
+// for upper_bound_index. The generic versions defer to the standard library.
+template <typename Coord>
+size_t lower_bound_index(const Coord *a, size_t n, Coord key) {
+  return std::lower_bound(a, a + n, key) - a;
+}
+
+template <typename Coord>
+size_t upper_bound_index(const Coord *a, size_t n, Coord key) {
+  return std::upper_bound(a, a + n, key) - a;
+}
+
+// Tuned 32-bit kernels: branchless halving that compiles to cmov and keeps
+// the index arithmetic in registers. Kept separate from the generic path so
+// wider coordinates cannot change the codegen of the common case.
+inline size_t lower_bound_index(const uint32_t *a, size_t n, uint32_t key) {
+  if (n == 0)
+    return 0;
+  const uint32_t *base = a;
+  while (n > 1) {
+    size_t half = n / 2;
+    base += (base[half - 1] < key) * half;
+    n -= half;
+  }
+  return (base - a) + (*base < key);
+}
+
+inline size_t upper_bound_index(const uint32_t *a, size_t n, uint32_t key) {
+  if (n == 0)
+    return 0;
+  const uint32_t *base = a;
+  while (n > 1) {
+    size_t half = n / 2;
+    base += (base[half - 1] <= key) * half;
+    n -= half;
+  }
+  return (base - a) + (*base <= key);
+}
+
+// A contiguous, start-sorted slice of a Lapper's columns whose intervals all
+// fall in one length range. Offsets are relative to the owning Lapper.
+template <typename Coord> struct BasicLengthClass {
+  size_t offset;
+  size_t length;
+  Coord max_len;
+};
+
+using LengthClass = BasicLengthClass<uint32_t>;
+
+template <typename Coord, typename Val> class BasicOverlapRange;
+
+// Non-owning view over one Lapper's columns, the C++ counterpart of
+// Lapper[owns_data=False]. All queries are implemented here so that Lapper
+// and LapperSet run the same code over their own storage.
+template <typename Coord, typename Val> struct BasicLapperView {
+  using I = BasicInterval<Coord, Val>;
+
+  const Coord *starts = nullptr;
+  const Coord *stops = nullptr;
+  const Val *vals = nullptr;
+  const Coord *stops_sorted = nullptr;
+  // Globally sorted starts for count. Equal to starts when there is a single
+  // length class, since starts is then already globally sorted.
+  const Coord *starts_sorted = nullptr;
+  const BasicLengthClass<Coord> *classes = nullptr;
+  size_t num_classes = 0;
+  size_t length = 0;
+  Coord max_len = 0;
+
+  // Calls f(row) for every row overlapping [start, stop), start-ordered
+  // within each length class, classes shortest first. Nothing is allocated
+  // and only the starts/stops columns are read; f picks the columns it needs.
+  template <typename F>
+  void for_each_overlap(Coord start, Coord stop, F &&f) const {
+    for (size_t k = 0; k < num_classes; k++) {
+      const BasicLengthClass<Coord> &c = classes[k];
+      size_t i = c.offset + lower_bound_index(starts + c.offset, c.length,
+                                              saturating_sub(start, c.max_len));
+      for (; i < c.offset + c.length; i++) {
+        if (I::overlap(starts[i], stops[i], start, stop))
+          f(i);
+        else if (starts[i] >= stop)
+          break;
+      }
+    }
+  }
+
+  // Lazy form of for_each_overlap: iterating the range yields row indices.
+  BasicOverlapRange<Coord, Val> overlaps(Coord start, Coord stop) const;
+
+  // Appends every interval overlapping [start, stop) to results, in
+  // for_each_overlap order.
+  void find(Coord start, Coord stop, std::vector<I> &results) const {
+    for_each_overlap(start, stop, [&](size_t i) {
+      results.push_back({starts[i], stops[i], vals[i]});
+    });
+  }
+
+  // Like find, but appends only the vals of the overlapping intervals. With
+  // row ids as vals this reads the start/stop keys plus one 32-bit column,
+  // leaving payloads to be fetched separately (see PayloadLapper).
+  void find_vals(Coord start, Coord stop, std::vector<Val> &out) const {
+    for_each_overlap(start, stop, [&](size_t i) { out.push_back(vals[i]); });
+  }
+
+  // Writes the row index of up to `capacity` overlapping intervals to rows
+  // and returns the total number of overlaps. A return value above capacity
+  // means rows was too small; the first capacity rows are still valid.
+  size_t find_into(Coord start, Coord stop, uint32_t *rows,
+                   size_t capacity) const {
+    size_t n = 0;
+    for_each_overlap(start, stop, [&](size_t i) {
+      if (n < capacity)
+        rows[n] = uint32_t(i);
+      n++;
+    });
+    return n;
+  }
+
+  // BITS count: total minus intervals that stop at or before start minus
+  // intervals that start at or after stop. The two sets are disjoint only
+  // when start < stop; an empty query [p, p) would subtract a zero-length
+  // [p, p) twice, so degenerate queries are counted by visiting, which
+  // agrees with find.
+  size_t count(Coord start, Coord stop) const {
+    if (start >= stop) {
+      size_t n = 0;
+      for_each_overlap(start, stop, [&](size_t) { n++; });
+      return n;
+    }
+    size_t stop_before = upper_bound_index(stops_sorted, length, start);
+    size_t start_after =
+        length - lower_bound_index(starts_sorted, length, stop);
+    return length - stop_before - start_after;
+  }
+
+  // Number of intervals covering position p, i.e. count(p, p + 1): starts at
+  // or before p minus stops at or before p.
+  size_t stab_count(Coord p) const {
+    return upper_bound_index(starts_sorted, length, p) -
+           upper_bound_index(stops_sorted, length, p);
+  }
+
+  // out[i] = stab_count(positions[i]), for millions of positions per call.
+  // Each thread takes a contiguous chunk. A sorted chunk, such as a per-base
+  // depth track, is answered by galloping forward through both sorted
+  // columns; any other chunk runs groups of positions through a lockstep
+  // branchless descent, fusing the two searches per position.
+  void stab_count_batch(const std::vector<Coord> &positions,
+                        std::vector<size_t> &out,
+                        unsigned threads = default_threads()) const {
+    out.resize(positions.size());
+    parallel_chunks(positions.size(), threads,
+                    [&](unsigned, size_t begin, size_t end) {
+                      const Coord *p = positions.data() + begin;
+                      size_t *o = out.data() + begin;
+                      if (std::is_sorted(p, p + (end - begin)))
+                        stab_count_sorted(p, end - begin, o);
+                      else
+                        stab_count_lockstep(p, end - begin, o);
+                    });
+  }
+
+  size_t size() const { return length; }
+
+  // All intervals in (start, stop) order, merging the class slices. Linear
+  // for a fixed number of classes.
+  std::vector<I> sorted_intervals() const {
+    std::vector<I> out;
+    out.reserve(length);
+    std::vector<size_t> cursor(num_classes);
+    for (size_t c = 0; c < num_classes; c++)
+      cursor[c] = classes[c].offset;
+    while (out.size() < length) {
+      size_t best = SIZE_MAX;
+      I next{};
+      for (size_t c = 0; c < num_classes; c++) {
+        size_t i = cursor[c];
+        if (i == classes[c].offset + classes[c].length)
+          continue;
+        I iv{starts[i], stops[i], vals[i]};
+        if (best == SIZE_MAX || iv < next) {
+          best = c;
+          next = iv;
+        }
+      }
+      cursor[best]++;
+      out.push_back(next);
+    }
+    return out;
+  }
+
+private:
+  static constexpr size_t stab_group = 16;
+
+  // Index of the first element of a[from, n) greater than key, searching
+  // forward from `from` in doubling steps.
+  static size_t gallop_upper(const Coord *a, size_t n, size_t from,
+                             Coord key) {
+    size_t step = 1, lo = from;
+    while (lo + step <= n && a[lo + step - 1] <= key) {
+      lo += step;
+      step *= 2;
+    }
+    size_t hi = std::min(n, lo + step);
+    return lo + upper_bound_index(a + lo, hi - lo, key);
+  }
+
+  void stab_count_sorted(const Coord *positions, size_t m,
+                         size_t *out) const {
+    size_t s = 0, e = 0;
+    for (size_t i = 0; i < m; i++) {
+      s = gallop_upper(starts_sorted, length, s, positions[i]);
+      e = gallop_upper(stops_sorted, length, e, positions[i]);
+      out[i] = s - e;
+    }
+  }
+
+  // Up to stab_group positions descend both columns together. Every search
+  // takes the same number of halving steps, so the lanes never diverge and
+  // the 2 * stab_group loads of a step are independent of one another.
+  void stab_count_group(const Coord *keys, size_t m, size_t *out) const {
+    if (length == 0) {
+      std::fill(out, out + m, size_t(0));
+      return;
+    }
+    size_t s[stab_group] = {}, e[stab_group] = {};
+    size_t n = length;
+    while (n > 1) {
+      size_t half = n / 2;
+      for (size_t l = 0; l < m; l++) {
+        s[l] += (starts_sorted[s[l] + half - 1] <= keys[l]) * half;
+        e[l] += (stops_sorted[e[l] + half - 1] <= keys[l]) * half;
+      }
+      n -= half;
+    }
+    for (size_t l = 0; l < m; l++)
+      out[l] = (s[l] + (starts_sorted[s[l]] <= keys[l])) -
+               (e[l] + (stops_sorted[e[l]] <= keys[l]));
+  }
+
+  void stab_count_lockstep(const Coord *positions, size_t m,
+                           size_t *out) const {
+    for (size_t i = 0; i < m; i += stab_group)
+      stab_count_group(positions + i, std::min(stab_group, m - i), out + i);
+  }
+};
+
+// Rows overlapping one query, produced on demand. Holds a copy of the view,
+// so it stays valid as long as the underlying columns do.
+template <typename Coord, typename Val> class BasicOverlapRange {
+public:
+  class iterator {
+  private:
+    const BasicOverlapRange *range;
+    size_t k;
+    size_t i;
+
+    void seek_class() {
+      const BasicLapperView<Coord, Val> &v = range->v;
+      for (; k < v.num_classes; k++) {
+        const BasicLengthClass<Coord> &c = v.classes[k];
+        i = c.offset + lower_bound_index(v.starts + c.offset, c.length,
+                                         saturating_sub(range->start,
+                                                        c.max_len));
+        if (seek_row())
+          return;
+      }
+    }
+
+    // Moves i to the next overlapping row of class k, false if there is none.
+    bool seek_row() {
+      const BasicLapperView<Coord, Val> &v = range->v;
+      const BasicLengthClass<Coord> &c = v.classes[k];
+      for (; i < c.offset + c.length; i++) {
+        if (BasicInterval<Coord, Val>::overlap(v.starts[i], v.stops[i],
+                                               range->start, range->stop))
+          return true;
+        if (v.starts[i] >= range->stop)
+          break;
+      }
+      return false;
+    }
+
+  public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = size_t;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const size_t *;
+    using reference = size_t;
+
+    iterator(const BasicOverlapRange *range, bool at_end)
+        : range(range), k(range->v.num_classes), i(0) {
+      if (!at_end) {
+        k = 0;
+        seek_class();
+      }
+    }
+
+    size_t operator*() const { return i; }
+
+    iterator &operator++() {
+      i++;
+      if (!seek_row()) {
+        k++;
+        seek_class();
+      }
+      return *this;
+    }
+
+    bool operator==(const iterator &other) const {
+      return k == other.k && (k == range->v.num_classes || i == other.i);
+    }
+
+    bool operator!=(const iterator &other) const { return !(*this == other); }
+  };
+
+  BasicOverlapRange(const BasicLapperView<Coord, Val> &v, Coord start,
+                    Coord stop)
+      : v(v), start(start), stop(stop) {}
+
+  iterator begin() const { return iterator(this, false); }
+
+  iterator end() const { return iterator(this, true); }
+
+private:
+  BasicLapperView<Coord, Val> v;
+  Coord start;
+  Coord stop;
+};
+
+template <typename Coord, typename Val>
+BasicOverlapRange<Coord, Val>
+BasicLapperView<Coord, Val>::overlaps(Coord start, Coord stop) const {
+  return BasicOverlapRange<Coord, Val>(*this, start, stop);
+}
+
+using LapperView = BasicLapperView<uint32_t, int32_t>;
+
+// Walks the rows of a view with start in [lo, hi), or at or after lo when
+// unbounded, in start order by merging the length-class slices on the fly.
+template <typename Coord, typename Val> class StartOrderCursor {
+private:
+  const BasicLapperView<Coord, Val> &v;
+  std::vector<size_t> pos;
+  std::vector<size_t> end;
+
+public:
+  StartOrderCursor(const BasicLapperView<Coord, Val> &v, Coord lo, Coord hi,
+                   bool unbounded)
+      : v(v), pos(v.num_classes), end(v.num_classes) {
+    for (size_t k = 0; k < v.num_classes; k++) {
+      const BasicLengthClass<Coord> &c = v.classes[k];
+      const Coord *s = v.starts + c.offset;
+      pos[k] = c.offset + lower_bound_index(s, c.length, lo);
+      end[k] = unbounded ? c.offset + c.length
+                         : c.offset + lower_bound_index(s, c.length, hi);
+    }
+  }
+
+  // Row with the smallest start, or SIZE_MAX when done.
+  size_t peek() const {
+    size_t best = SIZE_MAX;
+    for (size_t k = 0; k < pos.size(); k++) {
+      if (pos[k] < end[k] &&
+          (best == SIZE_MAX || v.starts[pos[k]] < v.starts[best]))
+        best = pos[k];
+    }
+    return best;
+  }
+
+  void advance(size_t row) {
+    for (size_t k = 0; k < pos.size(); k++) {
+      // An exhausted slice's position is the next slice's first row.
+      if (pos[k] == row && pos[k] < end[k]) {
+        pos[k]++;
+        return;
+      }
+    }
+  }
+};
+
+// Length classes for one set of start-sorted intervals, and the scatter that
+// lays the columns out accordingly.
+//
+// Intervals are bucketed by the bit width of their length, so a bucket holds
+// lengths within 2x of each other. Adjacent buckets are merged whenever that
+// is no more expensive than searching them separately: one more lower bound
+// against the extra candidates the shorter bucket would scan under the
+// longer one's max_len. Short or narrow length ranges therefore stay one
+// class, a wide range is split where it pays (lengths uniform in 1..10000
+// over 1M coordinates give 4 classes), and outliers such as a
+// whole-chromosome interval always get a class of their own.
+template <typename Coord, typename Val> class BasicLengthClassPlan {
+public:
+  using I = BasicInterval<Coord, Val>;
+
+  std::vector<BasicLengthClass<Coord>> classes;
+  Coord max_len = 0;
+
+private:
+  static constexpr int num_buckets = std::numeric_limits<Coord>::digits + 1;
+
+  bool split;
+  std::vector<int> bucket_class;
+
+  // Bit width of the interval length: 0 for empty intervals, 1 for length 1,
+  // 2 for 2..3 and so on.
+  static int length_bucket(Coord len) {
+    return len == 0 ? 0 : 64 - __builtin_clzll(uint64_t(len));
+  }
+
+  int class_of(const I &iv) const {
+    return bucket_class[split ? length_bucket(iv.stop - iv.start) : 0];
+  }
+
+  // Estimated cost of one find against a class: the lower bound plus the
+  // expected number of candidates that start within max_len of the query,
+  // assuming starts are spread evenly over `span`.
+  static double find_cost(size_t n, Coord class_max_len, double span) {
+    return std::log2(double(n) + 1) + double(n) * class_max_len / span;
+  }
+
+public:
+  // With split false every interval lands in one class with the global
+  // max_len, which is exactly the Mojo Lapper's behaviour.
+  BasicLengthClassPlan(const std::vector<I> &sorted, bool split)
+      : split(split), bucket_class(num_buckets, -1) {
+    std::vector<size_t> bucket_n(num_buckets, 0);
+    std::vector<Coord> bucket_max(num_buckets, 0);
+    Coord lo = sorted.empty() ? 0 : sorted.front().start, hi = 0;
+    for (const I &iv : sorted) {
+      Coord len = iv.stop - iv.start;
+      int b = split ? length_bucket(len) : 0;
+      bucket_n[b]++;
+      bucket_max[b] = std::max(bucket_max[b], len);
+      max_len = std::max(max_len, len);
+      hi = std::max(hi, iv.stop);
+    }
+    double span = std::max(1.0, double(hi) - double(lo));
+
+    size_t n = 0;
+    Coord group_max = 0;
+    for (size_t b = 0; b < bucket_n.size(); b++) {
+      if (bucket_n[b] == 0)
+        continue;
+      if (n > 0) {
+        double merged = find_cost(n + bucket_n[b], bucket_max[b], span);
+        double separate = find_cost(n, group_max, span) +
+                          find_cost(bucket_n[b], bucket_max[b], span);
+        if (merged > separate) {
+          classes.back().length = n;
+          classes.back().max_len = group_max;
+          n = 0;
+        }
+      }
+      if (n == 0)
+        classes.push_back({0, 0, 0});
+      n += bucket_n[b];
+      group_max = bucket_max[b];
+      bucket_class[b] = classes.size() - 1;
+    }
+    if (!classes.empty()) {
+      classes.back().length = n;
+      classes.back().max_len = group_max;
+    }
+    for (size_t c = 1; c < classes.size(); c++)
+      classes[c].offset = classes[c - 1].offset + classes[c - 1].length;
+  }
+
+  // With a single class starts is already globally sorted.
+  bool needs_starts_sorted() const { return classes.size() > 1; }
+
+  // Writes the start-sorted intervals into class slices. A stable scatter, so
+  // each slice stays sorted by start. starts_sorted is only written when
+  // needs_starts_sorted().
+  void scatter(const std::vector<I> &sorted, Coord *starts, Coord *stops,
+               Val *vals, Coord *starts_sorted) const {
+    std::vector<size_t> cursor(classes.size());
+    for (size_t c = 0; c < classes.size(); c++)
+      cursor[c] = classes[c].offset;
+    for (size_t j = 0; j < sorted.size(); j++) {
+      const I &iv = sorted[j];
+      size_t i = cursor[class_of(iv)]++;
+      starts[i] = iv.start;
+      stops[i] = iv.stop;
+      vals[i] = iv.val;
+      if (needs_starts_sorted())
+        starts_sorted[j] = iv.start;
+    }
+  }
+};
+
+using LengthClassPlan = BasicLengthClassPlan<uint32_t, int32_t>;
+
+// Fills out[0, n) with the stops of the start-sorted intervals, sorted.
+// Non-nested input already has its stops in order and skips the sort.
+template <typename Coord, typename Val>
+void fill_stops_sorted(const std::vector<BasicInterval<Coord, Val>> &sorted,
+                       Coord *out, unsigned threads = default_threads()) {
+  for (size_t i = 0; i < sorted.size(); i++)
+    out[i] = sorted[i].stop;
+  if (!std::is_sorted(out, out + sorted.size()))
+    radix_sort(out, sorted.size(), threads);
+}
+
+// C++ port of the Mojo Lapper (lapper/lapper.mojo).
+//
+// Storage is the same SoA layout: starts, stops and vals sorted by start, plus
+// an independently sorted stops_sorted for the BITS count.
+//
+// Unlike the Mojo version, find does not use a single global max_len. A single
+// whole-chromosome interval would otherwise push every lower bound back to the
+// start of the array. Instead intervals are split at build time into length
+// classes (see LengthClassPlan), each with its own max_len, so a find only
+// scans candidates that could overlap given the lengths in that class.
+template <typename Coord, typename Val> class BasicLapper {
+public:
+  using I = BasicInterval<Coord, Val>;
+  using View = BasicLapperView<Coord, Val>;
+
+private:
+  std::vector<Coord> starts;
+  std::vector<Coord> stops;
+  std::vector<Val> vals;
+  std::vector<Coord> stops_sorted;
+  std::vector<Coord> starts_sorted;
+  std::vector<BasicLengthClass<Coord>> classes;
+  Coord max_len = 0;
+  bool split = true;
+
+  // Builds the columns from start-sorted intervals. stops_sorted must already
+  // be filled in, either sorted from stops or merged from two Lappers.
+  void fill_sorted(const std::vector<I> &intervals) {
+    size_t n = intervals.size();
+    BasicLengthClassPlan<Coord, Val> plan(intervals, split);
+    starts.resize(n);
+    stops.resize(n);
+    vals.resize(n);
+    if (plan.needs_starts_sorted())
+      starts_sorted.resize(n);
+    plan.scatter(intervals, starts.data(), stops.data(), vals.data(),
+                 starts_sorted.data());
+    classes = std::move(plan.classes);
+    max_len = plan.max_len;
+  }
+
+  void fill(std::vector<I> &intervals) {
+    sort_intervals(intervals);
+    stops_sorted.resize(intervals.size());
+    fill_stops_sorted(intervals, stops_sorted.data());
+    fill_sorted(intervals);
+  }
+
+  BasicLapper() = default;
+
+public:
+  // Builds the index. Input order does not matter, and input that is already
+  // sorted skips the sort. With split_length_classes false all intervals
+  // share one class and one max_len, which is exactly the Mojo Lapper's
+  // behaviour.
+  explicit BasicLapper(std::vector<I> intervals,
+                       bool split_length_classes = true)
+      : split(split_length_classes) {
+    fill(intervals);
+  }
+
+  // Builds from intervals already sorted by (start, stop), such as the output
+  // of a sweep, without the sortedness check or the sort.
+  static BasicLapper from_sorted(std::vector<I> intervals,
+                                 bool split_length_classes = true) {
+    BasicLapper out;
+    out.split = split_length_classes;
+    out.stops_sorted.resize(intervals.size());
+    fill_stops_sorted(intervals, out.stops_sorted.data());
+    out.fill_sorted(intervals);
+    return out;
+  }
+
+  // Builds a Lapper holding every interval of a and b without re-sorting:
+  // both start orders and both stops_sorted columns are merged linearly.
+  // Intervals from a come before equal intervals from b. Length classes are
+  // re-planned for the combined data, using a's split_length_classes setting.
+  static BasicLapper merge(const BasicLapper &a, const BasicLapper &b) {
+    std::vector<I> ai = a.view().sorted_intervals();
+    std::vector<I> bi = b.view().sorted_intervals();
+    std::vector<I> merged(ai.size() + bi.size());
+    std::merge(ai.begin(), ai.end(), bi.begin(), bi.end(), merged.begin());
+
+    BasicLapper out;
+    out.split = a.split;
+    out.stops_sorted.resize(merged.size());
+    std::merge(a.stops_sorted.begin(), a.stops_sorted.end(),
+               b.stops_sorted.begin(), b.stops_sorted.end(),
+               out.stops_sorted.begin());
+    out.fill_sorted(merged);
+    return out;
+  }
+
+  View view() const {
+    View v;
+    v.starts = starts.data();
+    v.stops = stops.data();
+    v.vals = vals.data();
+    v.stops_sorted = stops_sorted.data();
+    v.starts_sorted = classes.size() > 1 ? starts_sorted.data() : starts.data();
+    v.classes = classes.data();
+    v.num_classes = classes.size();
+    v.length = starts.size();
+    v.max_len = max_len;
+    return v;
+  }
+
+  void find(Coord start, Coord stop, std::vector<I> &results) const {
+    view().find(start, stop, results);
+  }
+
+  void find_vals(Coord start, Coord stop, std::vector<Val> &out) const {
+    view().find_vals(start, stop, out);
+  }
+
+  template <typename F>
+  void for_each_overlap(Coord start, Coord stop, F &&f) const {
+    view().for_each_overlap(start, stop, std::forward<F>(f));
+  }
+
+  BasicOverlapRange<Coord, Val> overlaps(Coord start, Coord stop) const {
+    return view().overlaps(start, stop);
+  }
+
+  size_t find_into(Coord start, Coord stop, uint32_t *rows,
+                   size_t capacity) const {
+    return view().find_into(start, stop, rows, capacity);
+  }
+
+  size_t count(Coord start, Coord stop) const {
+    return view().count(start, stop);
+  }
+
+  size_t stab_count(Coord p) const { return view().stab_count(p); }
+
+  void stab_count_batch(const std::vector<Coord> &positions,
+                        std::vector<size_t> &out,
+                        unsigned threads = default_threads()) const {
+    view().stab_count_batch(positions, out, threads);
+  }
+
+  size_t size() const { return starts.size(); }
+
+  Coord get_max_len() const { return max_len; }
+
+  const std::vector<BasicLengthClass<Coord>> &length_classes() const {
+    return classes;
+  }
+};
+
+using Lapper = BasicLapper<uint32_t, int32_t>;
+using Lapper64 = BasicLapper<uint64_t, int64_t>;
+
+// Intervals whose val is a row id into a payload table kept elsewhere.
+using RowInterval = BasicInterval<uint32_t, uint32_t>;
+using RowLapper = BasicLapper<uint32_t, uint32_t>;
@@ -0,0 +1,1091 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <iomanip>
+#include <string>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <numeric>
+#include <set>
+#include <tuple>
+#include "bench_common.hpp"
+#include "ailist.hpp"
+#include "bed_loader.hpp"
+#include "itree.hpp"
+#include "join.hpp"
+#include "latency.hpp"
+#include "lapper_io.hpp"
+#include "lapper_set.hpp"
+#include "payload_lapper.hpp"
+#include "set_ops.hpp"
+#include "lapper.hpp"
+#include "nearest.hpp"
+
+// Same shape as benchmarks/bench_lapper.mojo: random starts, lengths 1..10000.
+std::vector<Interval> generate_intervals(int num_intervals, int max_coordinate, std::mt19937& gen) {
+    std::uniform_int_distribution<> start_dist(0, max_coordinate - 100);
+    std::uniform_int_distribution<> len_dist(1, 10000);
+    std::uniform_int_distribution<> val_dist(0, 1000);
+
+    std::vector<Interval> intervals(num_intervals);
+    for (Interval& iv : intervals) {
+        iv.start = start_dist(gen);
+        iv.stop = iv.start + len_dist(gen);
+        iv.val = val_dist(gen);
+    }
+    return intervals;
+}
+
+// Log-uniform lengths from 1 to max_len, so most intervals are short but many
+// are long enough to contain hundreds of others, like nested BED annotations.
+std::vector<Interval> generate_nested_intervals(int num_intervals, int max_coordinate, int max_len,
+                                                std::mt19937& gen) {
+    std::uniform_int_distribution<> start_dist(0, max_coordinate - 100);
+    std::uniform_real_distribution<> log_len_dist(0.0, std::log2((double)max_len));
+    std::uniform_int_distribution<> val_dist(0, 1000);
+
+    std::vector<Interval> intervals(num_intervals);
+    for (Interval& iv : intervals) {
+        iv.start = start_dist(gen);
+        iv.stop = iv.start + (uint32_t)std::exp2(log_len_dist(gen));
+        iv.val = val_dist(gen);
+    }
+    return intervals;
+}
+
+std::vector<Interval> generate_queries(int num_queries, int max_coordinate, std::mt19937& gen) {
+    std::uniform_int_distribution<> start_dist(0, max_coordinate - 50);
+    std::uniform_int_distribution<> len_dist(5, 50);
+
+    std::vector<Interval> queries(num_queries);
+    for (Interval& q : queries) {
+        q.start = start_dist(gen);
+        q.stop = q.start + len_dist(gen);
+        q.val = 0;
+    }
+    std::sort(queries.begin(), queries.end());
+    return queries;
+}
+
+// Reference answer: scan everything.
+std::vector<Interval> naive_find(const std::vector<Interval>& intervals, const Interval& q) {
+    std::vector<Interval> out;
+    for (const Interval& iv : intervals) {
+        if (iv.overlap(q.start, q.stop)) {
+            out.push_back(iv);
+        }
+    }
+    return out;
+}
+
+bool same_intervals(std::vector<Interval> a, std::vector<Interval> b) {
+    auto by_all = [](const Interval& x, const Interval& y) {
+        return x < y || (x == y && x.val < y.val);
+    };
+    std::sort(a.begin(), a.end(), by_all);
+    std::sort(b.begin(), b.end(), by_all);
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(),
+        [](const Interval& x, const Interval& y) { return x == y && x.val == y.val; });
+}
+
+template<typename Index>
+bool validate(const std::string& name, const Index& index,
+              const std::vector<Interval>& intervals, const std::vector<Interval>& queries) {
+    std::vector<Interval> results;
+    for (size_t i = 0; i < std::min<size_t>(queries.size(), 200); ++i) {
+        std::vector<Interval> expected = naive_find(intervals, queries[i]);
+        results.clear();
+        index.find(queries[i].start, queries[i].stop, results);
+        if (!same_intervals(results, expected) ||
+            index.count(queries[i].start, queries[i].stop) != expected.size()) {
+            std::cout << "ERROR: " << name << " mismatch for query [" << queries[i].start
+                      << "," << queries[i].stop << ")\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+void print_row(const std::string& name, double time_ms, double baseline_ms) {
+    std::cout << std::setw(40) << name
+              << std::setw(15) << std::fixed << std::setprecision(3) << time_ms
+              << std::setw(12) << std::fixed << std::setprecision(2) << (baseline_ms / time_ms) << "x" << std::endl;
+}
+
+void print_header() {
+    std::cout << std::setw(40) << "Algorithm" << std::setw(15) << "Time (ms)" << std::setw(12) << "Relative" << std::endl;
+    std::cout << std::string(67, '-') << std::endl;
+}
+
+// Compare a single global max_len (Mojo Lapper) with length classes.
+void benchmark_length_classes(const std::string& label, const std::vector<Interval>& intervals,
+                              const std::vector<Interval>& queries, int iterations) {
+    Lapper single(intervals, false);
+    Lapper classed(intervals);
+
+    std::cout << "\n=== " << label << " ===\n";
+    std::cout << "Length classes: " << classed.length_classes().size() << "\n";
+    if (!validate("single max_len", single, intervals, queries) ||
+        !validate("length classes", classed, intervals, queries)) {
+        std::exit(1);
+    }
+
+    print_header();
+    std::vector<Interval> results;
+    double single_find = benchmark_function([&]() {
+        for (const Interval& q : queries) {
+            results.clear();
+            single.find(q.start, q.stop, results);
+        }
+    }, iterations);
+    print_row("find (single max_len)", single_find, single_find);
+
+    double classed_find = benchmark_function([&]() {
+        for (const Interval& q : queries) {
+            results.clear();
+            classed.find(q.start, q.stop, results);
+        }
+    }, iterations);
+    print_row("find (length classes)", classed_find, single_find);
+
+    double single_count = benchmark_function([&]() {
+        volatile size_t dummy = 0;
+        for (const Interval& q : queries) {
+            dummy += single.count(q.start, q.stop);
+        }
+    }, iterations);
+    print_row("count (single max_len)", single_count, single_find);
+
+    double classed_count = benchmark_function([&]() {
+        volatile size_t dummy = 0;
+        for (const Interval& q : queries) {
+            dummy += classed.count(q.start, q.stop);
+        }
+    }, iterations);
+    print_row("count (length classes)", classed_count, single_find);
+}
+
+template<typename Index>
+double time_find(const Index& index, const std::vector<Interval>& queries, int iterations) {
+    std::vector<Interval> results;
+    return benchmark_function([&]() {
+        for (const Interval& q : queries) {
+            results.clear();
+            index.find(q.start, q.stop, results);
+        }
+    }, iterations);
+}
+
+template<typename Index>
+double time_count(const Index& index, const std::vector<Interval>& queries, int iterations) {
+    return benchmark_function([&]() {
+        volatile size_t dummy = 0;
+        for (const Interval& q : queries) {
+            dummy += index.count(q.start, q.stop);
+        }
+    }, iterations);
+}
+
+// Lapper (length classes) against the alternative index types.
+void benchmark_index_types(const std::string& label, const std::vector<Interval>& intervals,
+                           const std::vector<Interval>& queries, int iterations) {
+    Lapper lapper(intervals);
+    AIList ailist(intervals);
+    ImplicitIntervalTree itree(intervals);
+
+    std::cout << "\n=== Index types: " << label << " ===\n";
+    std::cout << "Lapper length classes: " << lapper.length_classes().size()
+              << ", AIList components: " << ailist.num_components()
+              << ", interval tree depth: " << itree.depth() << "\n";
+    if (!validate("Lapper", lapper, intervals, queries) ||
+        !validate("AIList", ailist, intervals, queries) ||
+        !validate("Implicit interval tree", itree, intervals, queries)) {
+        std::exit(1);
+    }
+
+    print_header();
+    double lapper_find = time_find(lapper, queries, iterations);
+    print_row("Lapper find", lapper_find, lapper_find);
+    print_row("AIList find", time_find(ailist, queries, iterations), lapper_find);
+    print_row("Implicit interval tree find", time_find(itree, queries, iterations), lapper_find);
+    print_row("Lapper count", time_count(lapper, queries, iterations), lapper_find);
+    print_row("AIList count", time_count(ailist, queries, iterations), lapper_find);
+    print_row("Implicit interval tree count", time_count(itree, queries, iterations), lapper_find);
+}
+
+// The same data in 32-bit and 64-bit coordinates, and shifted past 4 Gb so
+// only the 64-bit index can hold it. Query results must agree across widths.
+void benchmark_coordinate_widths(const std::vector<Interval>& intervals, const std::vector<Interval>& queries,
+                                 int iterations) {
+    const uint64_t shift = uint64_t(1) << 33;
+    auto widen = [](const std::vector<Interval>& in, uint64_t offset) {
+        std::vector<Interval64> out;
+        out.reserve(in.size());
+        for (const Interval& iv : in) {
+            out.push_back({iv.start + offset, iv.stop + offset, iv.val});
+        }
+        return out;
+    };
+    std::vector<Interval64> queries64 = widen(queries, 0);
+    std::vector<Interval64> shifted_queries = widen(queries, shift);
+    Lapper narrow(intervals);
+    Lapper64 wide(widen(intervals, 0));
+    Lapper64 shifted(widen(intervals, shift));
+
+    std::cout << "\n=== Coordinate widths ===\n";
+    if (!validate("Lapper", narrow, intervals, queries)) {
+        std::exit(1);
+    }
+    std::vector<Interval> expected;
+    std::vector<Interval64> results;
+    for (size_t i = 0; i < queries.size(); ++i) {
+        expected.clear();
+        narrow.find(queries[i].start, queries[i].stop, expected);
+        for (const Lapper64* index : {&wide, &shifted}) {
+            uint64_t offset = index == &wide ? 0 : shift;
+            results.clear();
+            index->find(queries[i].start + offset, queries[i].stop + offset, results);
+            bool same = results.size() == expected.size() &&
+                        index->count(queries[i].start + offset, queries[i].stop + offset) == expected.size();
+            for (size_t j = 0; same && j < results.size(); ++j) {
+                same = results[j].start == expected[j].start + offset &&
+                       results[j].stop == expected[j].stop + offset && results[j].val == expected[j].val;
+            }
+            if (!same) {
+                std::cout << "ERROR: Lapper64 mismatch for query [" << queries[i].start << ","
+                          << queries[i].stop << ") at offset " << offset << "\n";
+                std::exit(1);
+            }
+        }
+    }
+
+    print_header();
+    double build32 = benchmark_function([&]() { Lapper lapper(intervals); }, iterations);
+    print_row("build (32-bit)", build32, build32);
+    std::vector<Interval64> intervals64 = widen(intervals, shift);
+    print_row("build (64-bit)", benchmark_function([&]() { Lapper64 lapper(intervals64); }, iterations),
+              build32);
+
+    double find32 = time_find(narrow, queries, iterations);
+    print_row("find (32-bit)", find32, find32);
+    print_row("find (64-bit, past 4 Gb)", benchmark_function([&]() {
+        for (const Interval64& q : shifted_queries) {
+            results.clear();
+            shifted.find(q.start, q.stop, results);
+        }
+    }, iterations), find32);
+    print_row("count (32-bit)", time_count(narrow, queries, iterations), find32);
+    print_row("count (64-bit, past 4 Gb)", benchmark_function([&]() {
+        volatile size_t dummy = 0;
+        for (const Interval64& q : shifted_queries) {
+            dummy += shifted.count(q.start, q.stop);
+        }
+    }, iterations), find32);
+    print_row("count (64-bit, low coords)", benchmark_function([&]() {
+        volatile size_t dummy = 0;
+        for (const Interval64& q : queries64) {
+            dummy += wide.count(q.start, q.stop);
+        }
+    }, iterations), find32);
+}
+
+// A gene-sized payload stored inline as the Lapper val, against the same
+// payload in a cold column store behind 32-bit row ids.
+struct GeneRecord {
+    uint64_t gene_id;
+    float score;
+    char strand;
+};
+
+void benchmark_payloads(const std::vector<Interval>& intervals, const std::vector<Interval>& queries,
+                        int iterations) {
+    using GeneInterval = BasicInterval<uint32_t, GeneRecord>;
+    std::vector<GeneInterval> inline_intervals;
+    std::vector<RowInterval> row_intervals;
+    ColumnStore<uint64_t, float, char> store;
+    store.reserve(intervals.size());
+    for (const Interval& iv : intervals) {
+        GeneRecord gene{uint64_t(iv.val) * 7919, float(iv.val % 1000) / 10.0f, iv.val % 2 ? '+' : '-'};
+        inline_intervals.push_back({iv.start, iv.stop, gene});
+        uint32_t row = store.append(gene.gene_id, gene.score, gene.strand);
+        row_intervals.push_back({iv.start, iv.stop, row});
+    }
+    BasicLapper<uint32_t, GeneRecord> inline_lapper(inline_intervals);
+    PayloadLapper<uint64_t, float, char> payload_lapper(row_intervals, store);
+
+    std::cout << "\n=== Payload layout (" << sizeof(GeneInterval) << "-byte inline interval vs row id) ===\n";
+    std::vector<GeneInterval> inline_results;
+    std::vector<uint32_t> rows;
+    std::vector<float> scores;
+    for (const Interval& q : queries) {
+        inline_results.clear();
+        rows.clear();
+        inline_lapper.find(q.start, q.stop, inline_results);
+        payload_lapper.find_rows(q.start, q.stop, rows);
+        payload_lapper.payloads().gather<1>(rows, scores);
+        double inline_sum = 0, cold_sum = 0;
+        for (const GeneInterval& r : inline_results) inline_sum += r.val.score;
+        for (float s : scores) cold_sum += s;
+        if (rows.size() != inline_results.size() || inline_sum != cold_sum) {
+            std::cout << "ERROR: payload mismatch for query [" << q.start << "," << q.stop << ")\n";
+            std::exit(1);
+        }
+    }
+
+    print_header();
+    double inline_find = benchmark_function([&]() {
+        volatile double total = 0;
+        for (const Interval& q : queries) {
+            inline_results.clear();
+            inline_lapper.find(q.start, q.stop, inline_results);
+            for (const GeneInterval& r : inline_results) total += r.val.score;
+        }
+    }, iterations);
+    print_row("find + score (inline payload)", inline_find, inline_find);
+    print_row("find_rows + gather score", benchmark_function([&]() {
+        volatile double total = 0;
+        for (const Interval& q : queries) {
+            rows.clear();
+            payload_lapper.find_rows(q.start, q.stop, rows);
+            payload_lapper.payloads().gather<1>(rows, scores);
+            for (float s : scores) total += s;
+        }
+    }, iterations), inline_find);
+    print_row("find_rows only", benchmark_function([&]() {
+        for (const Interval& q : queries) {
+            rows.clear();
+            payload_lapper.find_rows(q.start, q.stop, rows);
+        }
+    }, iterations), inline_find);
+    print_row("count (inline payload)", time_count(inline_lapper, queries, iterations), inline_find);
+    print_row("count (row ids)", time_count(payload_lapper, queries, iterations), inline_find);
+}
+
+// Every query against every database interval: one find per query against a
+// single sweep over both indexes.
+void benchmark_join(const std::vector<Interval>& intervals, const std::vector<Interval>& queries,
+                    int iterations) {
+    Lapper database(intervals);
+    Lapper query_index(queries);
+    LapperView db = database.view(), qv = query_index.view();
+
+    std::cout << "\n=== Join (" << queries.size() << " queries x " << intervals.size() << " intervals) ===\n";
+    // Every (database row, query row) pair, found one query at a time.
+    std::vector<std::pair<uint32_t, uint32_t>> expected_pairs;
+    for (size_t j = 0; j < qv.length; ++j) {
+        db.for_each_overlap(qv.starts[j], qv.stops[j], [&](size_t i) { expected_pairs.emplace_back(i, j); });
+    }
+    std::sort(expected_pairs.begin(), expected_pairs.end());
+    size_t expected = expected_pairs.size();
+    // Sorted pair lists must match exactly, so pairs duplicated or dropped at
+    // the parallel cuts cannot hide behind a matching total.
+    for (unsigned threads : {1u, 2u, 8u, default_threads()}) {
+        JoinPairs found = join_pairs(db, qv, threads);
+        std::vector<std::pair<uint32_t, uint32_t>> got;
+        for (size_t i = 0; i < found.size(); ++i) got.emplace_back(found.rows_a[i], found.rows_b[i]);
+        std::sort(got.begin(), got.end());
+        if (got != expected_pairs) {
+            std::cout << "ERROR: join with " << threads << " threads returned different pairs (" << got.size()
+                      << " pairs, expected " << expected << ")\n";
+            std::exit(1);
+        }
+    }
+    std::cout << "Overlapping pairs: " << expected << "\n";
+
+    print_header();
+    JoinPairs pairs;
+    std::vector<Interval> results;
+    double per_query = benchmark_function([&]() {
+        results.clear();
+        for (const Interval& q : queries) {
+            database.find(q.start, q.stop, results);
+        }
+    }, iterations);
+    print_row("find per query", per_query, per_query);
+    print_row("join (1 thread, counting sink)", benchmark_function([&]() {
+        volatile size_t total = 0;
+        join(db, qv, [&](const uint32_t*, const uint32_t*, size_t n) { total += n; });
+    }, iterations), per_query);
+    print_row("join (1 thread, into JoinPairs)", benchmark_function([&]() {
+        pairs.rows_a.clear();
+        pairs.rows_b.clear();
+        join(db, qv, pairs);
+    }, iterations), per_query);
+    print_row("join_pairs (all threads)", benchmark_function([&]() { join_pairs(db, qv); }, iterations),
+              per_query);
+}
+
+// Brute-force check of closest and nearest at each position. A neighbor's
+// rank is (distance, side), with overlaps before upstream before downstream,
+// so nearest must return the k smallest ranks in order; which of several
+// intervals tied at the k-th rank it picks is free. closest must return
+// every interval at the best rank's distance, upstream before downstream.
+// nearest_batch must reproduce per-position nearest at any thread count.
+bool validate_nearest(const std::string& name, const LapperView& v, const std::vector<Interval>& genes,
+                      const std::vector<uint32_t>& positions, size_t k) {
+    using Key = std::tuple<int32_t, uint32_t, uint32_t>;  // (val, start, stop)
+    auto key = [](const Interval& iv) { return Key{iv.val, iv.start, iv.stop}; };
+    auto rank = [](const Interval& g, uint32_t p) {
+        if (g.overlap(p, p + 1)) return std::make_pair(0u, 0);
+        return g.stop <= p ? std::make_pair(p - g.stop, 1) : std::make_pair(g.start - (p + 1), 2);
+    };
+    auto fail = [&](const char* what, uint32_t p) {
+        std::cout << "ERROR: " << name << ": " << what << " mismatch at position " << p << "\n";
+        return false;
+    };
+    std::vector<Neighbor> found;
+    for (uint32_t p : positions) {
+        std::vector<std::pair<uint32_t, int>> ranks;
+        std::multiset<Key> by_key;
+        for (const Interval& g : genes) {
+            ranks.push_back(rank(g, p));
+            by_key.insert(key(g));
+        }
+        std::sort(ranks.begin(), ranks.end());
+
+        // Each reported neighbor is a distinct real interval with its own
+        // distance; returns the ranks in the order reported.
+        auto check_found = [&](std::vector<std::pair<uint32_t, int>>& got) {
+            std::multiset<Key> unused = by_key;
+            for (const Neighbor& n : found) {
+                auto it = unused.find(key(n.interval));
+                if (it == unused.end() || rank(n.interval, p).first != n.distance) return false;
+                unused.erase(it);
+                got.push_back(rank(n.interval, p));
+            }
+            return true;
+        };
+
+        found.clear();
+        nearest(v, p, k, found);
+        std::vector<std::pair<uint32_t, int>> got;
+        if (!check_found(got) || got.size() != std::min(k, ranks.size()) ||
+            !std::equal(got.begin(), got.end(), ranks.begin())) {
+            return fail("nearest", p);
+        }
+
+        found.clear();
+        closest(v, p, p + 1, found);
+        got.clear();
+        std::vector<std::pair<uint32_t, int>> expected;
+        for (const auto& r : ranks) {
+            bool overlaps = ranks[0].second == 0;
+            if (overlaps ? r.second == 0 : r.second != 0 && r.first == ranks[0].first) expected.push_back(r);
+        }
+        if (!check_found(got) || got != expected) {
+            return fail("closest", p);
+        }
+    }
+
+    std::vector<Neighbor> batch;
+    std::vector<size_t> offsets;
+    for (unsigned threads : {1u, 3u, 8u}) {
+        nearest_batch(v, positions, k, batch, offsets, threads);
+        if (offsets.size() != positions.size() + 1 || offsets[0] != 0 || offsets.back() != batch.size()) {
+            return fail("nearest_batch offsets", 0);
+        }
+        for (size_t i = 0; i < positions.size(); ++i) {
+            found.clear();
+            nearest(v, positions[i], k, found);
+            bool same = offsets[i + 1] - offsets[i] == found.size();
+            for (size_t j = 0; same && j < found.size(); ++j) {
+                const Neighbor& b = batch[offsets[i] + j];
+                same = key(b.interval) == key(found[j].interval) && b.distance == found[j].distance;
+            }
+            if (!same) {
+                return fail("nearest_batch", positions[i]);
+            }
+        }
+    }
+    return true;
+}
+
+// Closest / k-nearest lookups for variant-like positions against a sparse,
+// gene-like annotation where many positions overlap nothing.
+void benchmark_nearest(int num_genes, int num_positions, int max_coordinate, int iterations, std::mt19937& gen) {
+    std::vector<Interval> genes = generate_nested_intervals(num_genes, max_coordinate, 2000, gen);
+    Lapper lapper(genes);
+    LapperView v = lapper.view();
+    std::uniform_int_distribution<> pos_dist(0, max_coordinate - 1);
+    std::vector<uint32_t> positions(num_positions);
+    for (uint32_t& p : positions) {
+        p = pos_dist(gen);
+    }
+
+    std::cout << "\n=== Nearest (" << num_positions << " positions, " << num_genes << " genes) ===\n";
+    std::vector<uint32_t> checked(positions.begin(), positions.begin() + 200);
+    if (!validate_nearest("genes", v, genes, checked, 1) || !validate_nearest("genes", v, genes, checked, 10)) {
+        std::exit(1);
+    }
+    size_t misses = 0;
+    for (uint32_t p : checked) {
+        misses += lapper.count(p, p + 1) == 0;
+    }
+    // Few coordinates and many duplicates, so nearly every answer has ties,
+    // including touching and zero-length intervals.
+    std::vector<Interval> dense;
+    std::uniform_int_distribution<> dense_start(0, 200), dense_len(0, 6);
+    for (int i = 0; i < 300; ++i) {
+        uint32_t start = dense_start(gen);
+        dense.push_back({start, start + dense_len(gen), i});
+    }
+    dense.push_back(dense[0]);
+    dense.back().val = 300;
+    Lapper dense_lapper(dense);
+    std::vector<uint32_t> every_position(215);
+    std::iota(every_position.begin(), every_position.end(), 0);
+    for (size_t k : {size_t(1), size_t(10), dense.size() + 5}) {
+        if (!validate_nearest("dense", dense_lapper.view(), dense, every_position, k)) {
+            std::exit(1);
+        }
+    }
+    std::cout << "Positions overlapping nothing (first 200): " << misses << "\n";
+
+    print_header();
+    std::vector<Neighbor> found;
+    double closest_time = benchmark_function([&]() {
+        for (uint32_t p : positions) {
+            found.clear();
+            closest(v, p, p + 1, found);
+        }
+    }, iterations);
+    print_row("closest per position", closest_time, closest_time);
+    print_row("nearest k=1 per position", benchmark_function([&]() {
+        for (uint32_t p : positions) {
+            found.clear();
+            nearest(v, p, size_t(1), found);
+        }
+    }, iterations), closest_time);
+    print_row("nearest k=10 per position", benchmark_function([&]() {
+        for (uint32_t p : positions) {
+            found.clear();
+            nearest(v, p, size_t(10), found);
+        }
+    }, iterations), closest_time);
+    std::vector<size_t> offsets;
+    print_row("nearest_batch k=10 (1 thread)", benchmark_function([&]() {
+        nearest_batch(v, positions, 10, found, offsets, 1);
+    }, iterations), closest_time);
+    print_row("nearest_batch k=10 (all threads)", benchmark_function([&]() {
+        nearest_batch(v, positions, 10, found, offsets);
+    }, iterations), closest_time);
+}
+
+// Point depth: a per-base track (every position, sorted) and scattered
+// random positions, scalar count(p, p + 1) against stab_count_batch.
+void benchmark_stab_counts(const Lapper& lapper, int max_coordinate, int iterations, std::mt19937& gen) {
+    std::vector<uint32_t> track(max_coordinate);
+    for (int i = 0; i < max_coordinate; ++i) {
+        track[i] = i;
+    }
+    std::vector<uint32_t> scattered(max_coordinate);
+    std::uniform_int_distribution<> pos_dist(0, max_coordinate - 1);
+    for (uint32_t& p : scattered) {
+        p = pos_dist(gen);
+    }
+
+    std::cout << "\n=== Stab counts (" << max_coordinate << " positions) ===\n";
+    std::vector<size_t> out;
+    for (const std::vector<uint32_t>* positions : {&track, &scattered}) {
+        lapper.stab_count_batch(*positions, out);
+        for (size_t i = 0; i < positions->size(); i += 997) {
+            uint32_t p = (*positions)[i];
+            if (out[i] != lapper.count(p, p + 1)) {
+                std::cout << "ERROR: stab count mismatch at position " << p << "\n";
+                std::exit(1);
+            }
+        }
+    }
+
+    print_header();
+    auto scalar = [&](const std::vector<uint32_t>& positions) {
+        return benchmark_function([&]() {
+            out.resize(positions.size());
+            for (size_t i = 0; i < positions.size(); ++i) {
+                out[i] = lapper.count(positions[i], positions[i] + 1);
+            }
+        }, iterations);
+    };
+    double track_scalar = scalar(track);
+    print_row("per-base: count per position", track_scalar, track_scalar);
+    print_row("per-base: stab_count_batch (1 thread)", benchmark_function([&]() {
+        lapper.stab_count_batch(track, out, 1);
+    }, iterations), track_scalar);
+    print_row("per-base: stab_count_batch (all)", benchmark_function([&]() {
+        lapper.stab_count_batch(track, out);
+    }, iterations), track_scalar);
+    double scattered_scalar = scalar(scattered);
+    print_row("random: count per position", scattered_scalar, scattered_scalar);
+    print_row("random: stab_count_batch (1 thread)", benchmark_function([&]() {
+        lapper.stab_count_batch(scattered, out, 1);
+    }, iterations), scattered_scalar);
+    print_row("random: stab_count_batch (all)", benchmark_function([&]() {
+        lapper.stab_count_batch(scattered, out);
+    }, iterations), scattered_scalar);
+}
+
+// Ways of consuming find results: materialized Interval structs against the
+// visitor, the lazy range and row ids into a fixed buffer. Each variant sums
+// the vals so every match is actually read.
+void benchmark_result_apis(const Lapper& lapper, const std::vector<Interval>& queries, int iterations) {
+    LapperView v = lapper.view();
+    std::vector<Interval> results;
+    std::vector<uint32_t> rows(1 << 16);
+
+    std::cout << "\n=== Result APIs ===\n";
+    for (const Interval& q : queries) {
+        results.clear();
+        lapper.find(q.start, q.stop, results);
+        long long expected = 0, visited = 0, ranged = 0, buffered = 0;
+        for (const Interval& r : results) expected += r.val;
+        lapper.for_each_overlap(q.start, q.stop, [&](size_t i) { visited += v.vals[i]; });
+        for (size_t i : lapper.overlaps(q.start, q.stop)) ranged += v.vals[i];
+        size_t n = lapper.find_into(q.start, q.stop, rows.data(), rows.size());
+        for (size_t i = 0; i < std::min(n, rows.size()); ++i) buffered += v.vals[rows[i]];
+        if (n > rows.size() || visited != expected || ranged != expected || buffered != expected) {
+            std::cout << "ERROR: result API mismatch for query [" << q.start << "," << q.stop << ")\n";
+            std::exit(1);
+        }
+    }
+
+    print_header();
+    double find_time = benchmark_function([&]() {
+        volatile long long total = 0;
+        for (const Interval& q : queries) {
+            results.clear();
+            lapper.find(q.start, q.stop, results);
+            for (const Interval& r : results) total += r.val;
+        }
+    }, iterations);
+    print_row("find into vector<Interval>", find_time, find_time);
+    print_row("for_each_overlap", benchmark_function([&]() {
+        volatile long long total = 0;
+        for (const Interval& q : queries) {
+            long long sum = 0;
+            lapper.for_each_overlap(q.start, q.stop, [&](size_t i) { sum += v.vals[i]; });
+            total += sum;
+        }
+    }, iterations), find_time);
+    print_row("overlaps() range", benchmark_function([&]() {
+        volatile long long total = 0;
+        for (const Interval& q : queries) {
+            long long sum = 0;
+            for (size_t i : lapper.overlaps(q.start, q.stop)) sum += v.vals[i];
+            total += sum;
+        }
+    }, iterations), find_time);
+    print_row("find_into row buffer", benchmark_function([&]() {
+        volatile long long total = 0;
+        for (const Interval& q : queries) {
+            size_t n = lapper.find_into(q.start, q.stop, rows.data(), rows.size());
+            long long sum = 0;
+            for (size_t i = 0; i < n; ++i) sum += v.vals[rows[i]];
+            total += sum;
+        }
+    }, iterations), find_time);
+}
+
+// Per-query tails of the find and count paths, timed one query at a time
+// with the TSC. Every row includes the timestamp overhead shown first.
+void benchmark_latency(const Lapper& lapper, const std::vector<Interval>& queries, int iterations) {
+    TscClock clock;
+    std::vector<Interval> results;
+    volatile long long sink = 0;
+    auto latency = [&](const std::string& name, auto&& query) {
+        for (size_t i = 0; i < queries.size(); ++i) query(queries[i]);
+        LatencyHistogram hist;
+        for (int t = 0; t < iterations; ++t) {
+            record_latency(hist, [&](size_t i) { query(queries[i]); }, queries.size(), 1);
+        }
+        print_latency_row(name, 40, hist, clock);
+    };
+
+    std::cout << "\n=== Query latency ===\n";
+    print_latency_header(40);
+    print_latency_row("timestamp overhead", 40, timer_overhead(), clock);
+    latency("find", [&](const Interval& q) {
+        results.clear();
+        lapper.find(q.start, q.stop, results);
+        sink += results.size();
+    });
+    latency("count", [&](const Interval& q) { sink += lapper.count(q.start, q.stop); });
+    latency("stab_count", [&](const Interval& q) { sink += lapper.stab_count(q.start); });
+}
+
+// Set algebra against the old route of materializing intervals, merging them
+// by hand and rebuilding a Lapper from the result.
+void benchmark_set_ops(const std::vector<Interval>& a_intervals, const std::vector<Interval>& b_intervals,
+                       int max_coordinate, int iterations) {
+    Lapper a(a_intervals);
+    Lapper b(b_intervals);
+    LapperView av = a.view(), bv = b.view();
+    uint32_t hi = max_coordinate + 20000;
+
+    // Expected results, independent of set_ops: a naive sort-and-merge for the
+    // union, and the maximal runs of a coverage bitmap for the rest.
+    std::vector<Interval> sorted_a = a_intervals;
+    std::sort(sorted_a.begin(), sorted_a.end());
+    std::vector<Interval> naive_merge;
+    for (const Interval& iv : sorted_a) {
+        if (!naive_merge.empty() && iv.start <= naive_merge.back().stop) {
+            naive_merge.back().stop = std::max(naive_merge.back().stop, iv.stop);
+        } else {
+            naive_merge.push_back({iv.start, iv.stop, 0});
+        }
+    }
+    std::vector<char> in_a(hi, 0), in_b(hi, 0);
+    for (const Interval& iv : a_intervals) std::fill(in_a.begin() + iv.start, in_a.begin() + iv.stop, 1);
+    for (const Interval& iv : b_intervals) std::fill(in_b.begin() + iv.start, in_b.begin() + iv.stop, 1);
+    auto runs = [&](auto&& member) {
+        std::vector<Interval> out;
+        for (uint32_t c = 0; c < hi; ++c) {
+            if (!member(c)) continue;
+            if (!out.empty() && out.back().stop == c) {
+                ++out.back().stop;
+            } else {
+                out.push_back({c, c + 1, 0});
+            }
+        }
+        return out;
+    };
+    std::vector<Interval> both = runs([&](uint32_t c) { return in_a[c] && in_b[c]; });
+    std::vector<Interval> a_only = runs([&](uint32_t c) { return in_a[c] && !in_b[c]; });
+    std::vector<Interval> gaps = runs([&](uint32_t c) { return !in_a[c]; });
+
+    // Output must be sorted, disjoint and non-adjacent, i.e. exactly the
+    // expected maximal intervals, including across the cuts between threads.
+    auto check = [&](const std::string& name, const Lapper& result, const std::vector<Interval>& expected) {
+        std::vector<Interval> got = result.view().sorted_intervals();
+        for (size_t i = 0; i < got.size(); ++i) {
+            if (got[i].start >= got[i].stop || (i > 0 && got[i - 1].stop >= got[i].start)) {
+                std::cout << "ERROR: " << name << " output not maximal at [" << got[i].start << ", "
+                          << got[i].stop << ")\n";
+                std::exit(1);
+            }
+        }
+        for (size_t i = 0; i < std::max(got.size(), expected.size()); ++i) {
+            if (i >= got.size() || i >= expected.size() || got[i].start != expected[i].start ||
+                got[i].stop != expected[i].stop) {
+                std::cout << "ERROR: " << name << " differs from the naive result at interval " << i << " ("
+                          << got.size() << " vs " << expected.size() << " intervals)\n";
+                std::exit(1);
+            }
+        }
+    };
+    for (unsigned threads : {1u, 3u, 8u}) {
+        std::string suffix = " (" + std::to_string(threads) + " threads)";
+        check("merge_overlaps" + suffix, merge_overlaps(av, threads), naive_merge);
+        check("intersect" + suffix, intersect(av, bv, threads), both);
+        check("subtract" + suffix, subtract(av, bv, threads), a_only);
+        check("complement" + suffix, complement(av, 0u, hi, threads), gaps);
+    }
+
+    std::cout << "\n=== Set operations (" << a_intervals.size() << " x " << b_intervals.size() << " intervals) ===\n";
+    print_header();
+    double rebuild = benchmark_function([&]() {
+        std::vector<Interval> sorted = av.sorted_intervals();
+        std::vector<Interval> out;
+        for (const Interval& iv : sorted) {
+            if (!out.empty() && iv.start <= out.back().stop) {
+                out.back().stop = std::max(out.back().stop, iv.stop);
+            } else {
+                out.push_back({iv.start, iv.stop, 0});
+            }
+        }
+        Lapper lapper(out);
+    }, iterations);
+    print_row("merge: materialize + rebuild", rebuild, rebuild);
+    print_row("merge_overlaps (1 thread)", benchmark_function([&]() { merge_overlaps(av, 1); }, iterations),
+              rebuild);
+    print_row("merge_overlaps (all threads)", benchmark_function([&]() { merge_overlaps(av); }, iterations),
+              rebuild);
+    print_row("intersect", benchmark_function([&]() { intersect(av, bv); }, iterations), rebuild);
+    print_row("subtract", benchmark_function([&]() { subtract(av, bv); }, iterations), rebuild);
+    print_row("complement", benchmark_function([&]() { complement(av, 0u, hi); }, iterations), rebuild);
+}
+
+// Build from shuffled vs. already sorted input, and merge vs. rebuild.
+void benchmark_construction(const std::vector<Interval>& intervals, const std::vector<Interval>& queries,
+                            int iterations) {
+    std::vector<Interval> sorted = intervals;
+    std::sort(sorted.begin(), sorted.end());
+    std::vector<Interval> first_half(intervals.begin(), intervals.begin() + intervals.size() / 2);
+    std::vector<Interval> second_half(intervals.begin() + intervals.size() / 2, intervals.end());
+    Lapper a(first_half);
+    Lapper b(second_half);
+
+    std::cout << "\n=== Construction ===\n";
+    if (!validate("merge", Lapper::merge(a, b), intervals, queries)) {
+        std::exit(1);
+    }
+
+    print_header();
+    double unsorted_build = benchmark_function([&]() { Lapper lapper(intervals); }, iterations);
+    print_row("build (unsorted input)", unsorted_build, unsorted_build);
+    double sorted_build = benchmark_function([&]() { Lapper lapper(sorted); }, iterations);
+    print_row("build (sorted input)", sorted_build, unsorted_build);
+    double rebuild = benchmark_function([&]() {
+        std::vector<Interval> both = first_half;
+        both.insert(both.end(), second_half.begin(), second_half.end());
+        Lapper lapper(both);
+    }, iterations);
+    print_row("rebuild from both halves", rebuild, unsorted_build);
+    double merge = benchmark_function([&]() { Lapper lapper = Lapper::merge(a, b); }, iterations);
+    print_row("Lapper::merge of both halves", merge, unsorted_build);
+}
+
+// Many small contigs: one Lapper per contig vs. a single-arena LapperSet.
+void benchmark_lapper_set(int num_contigs, int num_intervals, int num_queries, int iterations,
+                          std::mt19937& gen) {
+    // Contig sizes fall off like chromosome sizes: a few big, many small.
+    std::vector<std::vector<Interval>> per_contig(num_contigs);
+    std::uniform_real_distribution<> unit(0.0, 1.0);
+    for (int i = 0; i < num_intervals; ++i) {
+        int contig = (int)(num_contigs * unit(gen) * unit(gen));
+        uint32_t start = (uint32_t)(unit(gen) * 1000000);
+        per_contig[contig].push_back({start, start + 1 + (uint32_t)(unit(gen) * 10000), i});
+    }
+    std::vector<ContigQuery> queries(num_queries);
+    for (ContigQuery& q : queries) {
+        q.contig = (uint32_t)(num_contigs * unit(gen) * unit(gen));
+        q.start = (uint32_t)(unit(gen) * 1000000);
+        q.stop = q.start + 50;
+    }
+
+    std::cout << "\n=== " << num_contigs << " contigs: per-contig Lappers vs LapperSet ===\n";
+    std::vector<Lapper> lappers;
+    print_header();
+    double lappers_build = benchmark_function([&]() {
+        lappers.clear();
+        for (const std::vector<Interval>& ivs : per_contig) {
+            lappers.emplace_back(ivs);
+        }
+    }, 1);
+    print_row("build (Lapper per contig)", lappers_build, lappers_build);
+    LapperSet set({});
+    double set_build = benchmark_function([&]() { set = LapperSet(per_contig); }, 1);
+    print_row("build (LapperSet)", set_build, lappers_build);
+
+    std::vector<size_t> counts;
+    set.count_batch(queries, counts);
+    std::vector<Interval> results;
+    std::vector<size_t> offsets;
+    set.find_batch(queries, results, offsets);
+    for (size_t i = 0; i < queries.size(); ++i) {
+        std::vector<Interval> expected;
+        lappers[queries[i].contig].find(queries[i].start, queries[i].stop, expected);
+        std::vector<Interval> got(results.begin() + offsets[i], results.begin() + offsets[i + 1]);
+        if (counts[i] != expected.size() || !same_intervals(got, expected)) {
+            std::cout << "ERROR: LapperSet mismatch for query " << i << "\n";
+            std::exit(1);
+        }
+    }
+
+    double lappers_count = benchmark_function([&]() {
+        volatile size_t dummy = 0;
+        for (const ContigQuery& q : queries) {
+            dummy += lappers[q.contig].count(q.start, q.stop);
+        }
+    }, iterations);
+    print_row("count (Lapper per contig)", lappers_count, lappers_count);
+    double set_count = benchmark_function([&]() {
+        volatile size_t dummy = 0;
+        for (const ContigQuery& q : queries) {
+            dummy += set.count(q.contig, q.start, q.stop);
+        }
+    }, iterations);
+    print_row("count (LapperSet)", set_count, lappers_count);
+    double set_count_batch = benchmark_function([&]() { set.count_batch(queries, counts); }, iterations);
+    print_row("count_batch (LapperSet, all threads)", set_count_batch, lappers_count);
+}
+
+// One BED record as (contig, start, stop, val), for comparing loaders.
+using BedRow = std::tuple<std::string, uint32_t, uint32_t, int32_t>;
+
+std::vector<BedRow> bed_rows(const BedData& bed) {
+    std::vector<BedRow> rows;
+    for (size_t c = 0; c < bed.per_contig.size(); ++c) {
+        for (const Interval& iv : bed.per_contig[c]) {
+            rows.emplace_back(bed.contig_names[c], iv.start, iv.stop, iv.val);
+        }
+    }
+    std::sort(rows.begin(), rows.end());
+    return rows;
+}
+
+// Parse a generated BED file: getline + istringstream vs. the mmap loader.
+// The file mixes in CRLF line endings, comment, track and browser lines,
+// and ends without a newline, and every loader must return exactly the rows
+// the getline parse finds.
+void benchmark_bed_loader(int num_lines, int num_contigs, std::mt19937& gen) {
+    std::string path = (std::filesystem::temp_directory_path() / "lapper_benchmark.bed").string();
+    {
+        std::ofstream out(path);
+        std::uniform_int_distribution<> contig_dist(0, num_contigs - 1);
+        std::uniform_int_distribution<> start_dist(0, 200000000);
+        std::uniform_int_distribution<> len_dist(1, 10000);
+        out << "browser position chr1:1-1000\ntrack name=features\n";
+        for (int i = 0; i < num_lines; ++i) {
+            if (i % 1000 == 500) {
+                out << "# comment " << i << "\n";
+            }
+            int start = start_dist(gen);
+            out << "chr" << contig_dist(gen) << "\t" << start << "\t" << start + len_dist(gen);
+            if (i % 3 == 0) {
+                out << "\tfeature" << i << "\t0\t+";
+            }
+            if (i + 1 < num_lines) {
+                out << (i % 5 == 0 ? "\r\n" : "\n");
+            }
+        }
+    }
+
+    std::cout << "\n=== BED loading (" << num_lines << " lines) ===\n";
+    print_header();
+    std::vector<BedRow> expected;
+    double naive = benchmark_function([&]() {
+        std::ifstream in(path);
+        std::string line, contig;
+        expected.clear();
+        while (std::getline(in, line)) {
+            if (line.empty() || line[0] == '#' || line.rfind("track", 0) == 0 || line.rfind("browser", 0) == 0) {
+                continue;
+            }
+            std::istringstream fields(line);
+            uint32_t start = 0, stop = 0;
+            fields >> contig >> start >> stop;
+            expected.emplace_back(contig, start, stop, (int32_t)expected.size());
+        }
+    }, 1);
+    print_row("getline + istringstream", naive, naive);
+    std::sort(expected.begin(), expected.end());
+
+    double one_thread = benchmark_function([&]() { BedData bed = read_bed(path, 1); }, 1);
+    print_row("read_bed (1 thread)", one_thread, naive);
+    double all_threads = benchmark_function([&]() { BedData bed = read_bed(path); }, 1);
+    print_row("read_bed (all threads)", all_threads, naive);
+    double to_set = benchmark_function([&]() { LapperSet set = load_bed(path); }, 1);
+    print_row("load_bed into LapperSet", to_set, naive);
+
+    // Explicit thread counts too, so the cross-chunk scatter is exercised on
+    // a single-core host.
+    for (unsigned threads : {1u, 3u, 8u, default_threads()}) {
+        if (bed_rows(read_bed(path, threads)) != expected) {
+            std::cout << "ERROR: read_bed with " << threads << " threads disagrees with the getline parse\n";
+            std::exit(1);
+        }
+    }
+
+    // Coordinates that do not fit 32 bits must be rejected, not wrapped.
+    const std::pair<const char*, bool> edge_lines[] = {
+        {"chr1\t18446744073709551617\t18446744073709551620\n", false},
+        {"chr1\t0\t4294967296\n", false},
+        {"chr1\t0\t00000000001\n", false},
+        {"chr1\t4294967295\t4294967295\n", true},
+        {"chr1\t0000000001\t0000000002\n", true},
+    };
+    for (const auto& [line, valid] : edge_lines) {
+        std::ofstream(path) << line;
+        bool loaded = true;
+        try {
+            read_bed(path, 1);
+        } catch (const std::runtime_error&) {
+            loaded = false;
+        }
+        if (loaded != valid) {
+            std::cout << "ERROR: read_bed " << (loaded ? "accepted" : "rejected") << " " << line;
+            std::exit(1);
+        }
+    }
+    std::remove(path.c_str());
+}
+
+// Building from intervals vs. opening a saved, mmapped Lapper file.
+void benchmark_serialization(const std::vector<Interval>& intervals, const std::vector<Interval>& queries,
+                             int iterations) {
+    std::string path = (std::filesystem::temp_directory_path() / "lapper_benchmark.lapper").string();
+    Lapper lapper(intervals);
+    save_lapper(lapper, path);
+
+    std::cout << "\n=== Serialized Lapper ===\n";
+    {
+        MappedLapper mapped(path);
+        if (!validate("MappedLapper", mapped, intervals, queries)) {
+            std::exit(1);
+        }
+    }
+
+    print_header();
+    double build = benchmark_function([&]() { Lapper built(intervals); }, iterations);
+    print_row("build from intervals", build, build);
+    double open = benchmark_function([&]() { MappedLapper mapped(path); }, iterations);
+    print_row("open mmapped file", open, build);
+    double open_and_query = benchmark_function([&]() {
+        MappedLapper mapped(path);
+        volatile size_t dummy = 0;
+        for (const Interval& q : queries) {
+            dummy += mapped.count(q.start, q.stop);
+        }
+    }, iterations);
+    print_row("open mmapped file + count queries", open_and_query, build);
+    std::remove(path.c_str());
+}
+
+int main() {
+    const int num_intervals = 100000;  // Same as Mojo version
+    const int num_queries = 10000;
+    const int max_coordinate = 1000000;
+    const int benchmark_iterations = 10;
+
+    std::mt19937 gen(42);
+    std::cout << "Generating " << num_intervals << " intervals and " << num_queries << " queries...\n";
+    std::vector<Interval> intervals = generate_intervals(num_intervals, max_coordinate, gen);
+    std::vector<Interval> queries = generate_queries(num_queries, max_coordinate, gen);
+
+    // Zero-length intervals and empty or reversed queries, where the BITS
+    // count would otherwise subtract the same interval twice.
+    std::vector<Interval> degenerate = {{5, 5, 0}, {2, 8, 1}, {5, 6, 2}, {0, 5, 3}, {9, 9, 4}, {5, 5, 5}};
+    std::vector<Interval> degenerate_queries = {{5, 5, 0}, {4, 4, 0}, {6, 6, 0}, {9, 9, 0}, {0, 10, 0},
+                                                {5, 6, 0}, {8, 3, 0}, {0, 0, 0}};
+    if (!validate("degenerate queries", Lapper(degenerate), degenerate, degenerate_queries)) {
+        std::exit(1);
+    }
+
+    benchmark_length_classes("Uniform lengths", intervals, queries, benchmark_iterations);
+
+    // A handful of whole-range annotations, like a chromosome-spanning feature.
+    std::vector<Interval> with_outliers = intervals;
+    for (int i = 0; i < 4; ++i) {
+        with_outliers.push_back({0, (uint32_t)max_coordinate, -1});
+    }
+    benchmark_length_classes("Uniform lengths + 4 whole-range intervals", with_outliers, queries,
+                             benchmark_iterations);
+
+    benchmark_construction(intervals, queries, benchmark_iterations);
+    benchmark_coordinate_widths(with_outliers, queries, benchmark_iterations);
+    benchmark_payloads(intervals, queries, benchmark_iterations);
+    benchmark_join(with_outliers, queries, benchmark_iterations);
+    // Short intervals at ~1x coverage, so unions break into tens of thousands
+    // of pieces, many of them meeting end to start, and the gaps are real.
+    benchmark_set_ops(generate_nested_intervals(num_intervals, max_coordinate, 40, gen),
+                      generate_nested_intervals(num_intervals / 10, max_coordinate, 100, gen), max_coordinate,
+                      benchmark_iterations);
+    benchmark_result_apis(Lapper(with_outliers), queries, benchmark_iterations);
+    benchmark_latency(Lapper(with_outliers), queries, benchmark_iterations);
+    benchmark_stab_counts(Lapper(with_outliers), max_coordinate, benchmark_iterations, gen);
+    benchmark_nearest(2000, 200000, max_coordinate, benchmark_iterations, gen);
+
+    benchmark_serialization(with_outliers, queries, benchmark_iterations);
+    benchmark_bed_loader(1000000, 25, gen);
+    benchmark_lapper_set(3000, 1000000, 100000, benchmark_iterations, gen);
+
+    benchmark_index_types("uniform lengths", intervals, queries, benchmark_iterations);
+    std::vector<Interval> nested = generate_nested_intervals(num_intervals, max_coordinate, 200000, gen);
+    benchmark_index_types("nested, log-uniform lengths", nested, queries, benchmark_iterations);
+
+    return 0;
+}
@@ -0,0 +1,214 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "lapper.hpp"
+#include "mapped_file.hpp"
+
+// On-disk Lapper format, designed to be queried straight from an mmap.
+//
+// Layout, in the writer's native byte order (a reader on the other order sees
+// a mismatched byte_order_mark and refuses the file), every section starting
+// on a 4096-byte page:
+//   page 0       LapperFileHeader
+//   starts       length x uint32
+//   stops        length x uint32
+//   vals         length x int32
+//   stops_sorted length x uint32
+//   starts_sorted length x uint32, only when num_classes > 1
+//   classes      num_classes x LengthClass (uint64 offset, uint64 length,
+//                uint32 max_len, 4 bytes padding)
+//
+// Opening a file is a header check plus pointer arithmetic; no sort or copy.
+// The header is untrusted: every section must lie inside the file and every
+// length class inside the columns before anything is dereferenced.
+namespace lapper_io {
+
+constexpr char magic[8] = {'L', 'A', 'P', 'P', 'E', 'R', '\0', '\0'};
+constexpr uint32_t version = 1;
+constexpr uint32_t byte_order_mark = 0x01020304;
+constexpr size_t page_size = 4096;
+
+static_assert(sizeof(size_t) == 8 && sizeof(LengthClass) == 24,
+              "LengthClass must match the on-disk layout");
+
+enum Section {
+  section_starts,
+  section_stops,
+  section_vals,
+  section_stops_sorted,
+  section_starts_sorted,
+  section_classes,
+  num_sections
+};
+
+} // namespace lapper_io
+
+struct LapperFileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t byte_order_mark;
+  uint64_t length;
+  uint64_t num_classes;
+  uint32_t max_len;
+  uint32_t reserved;
+  // Byte offset of each section from the start of the file, 0 when absent.
+  uint64_t offsets[lapper_io::num_sections];
+  uint64_t file_size;
+};
+
+// Writes the columns behind a view, e.g. Lapper::view() or one contig of a
+// LapperSet, to path.
+inline void save_lapper(const LapperView &view, const std::string &path) {
+  using namespace lapper_io;
+  size_t n = view.length;
+  bool has_starts_sorted = view.num_classes > 1;
+  const void *data[num_sections] = {view.starts,       view.stops,
+                                    view.vals,         view.stops_sorted,
+                                    view.starts_sorted, view.classes};
+  size_t bytes[num_sections] = {4 * n, 4 * n, 4 * n, 4 * n,
+                                has_starts_sorted ? 4 * n : 0,
+                                sizeof(LengthClass) * view.num_classes};
+
+  LapperFileHeader header = {};
+  std::memcpy(header.magic, magic, sizeof(magic));
+  header.version = version;
+  header.byte_order_mark = byte_order_mark;
+  header.length = n;
+  header.num_classes = view.num_classes;
+  header.max_len = view.max_len;
+  size_t offset = page_size;
+  for (int s = 0; s < num_sections; s++) {
+    if (bytes[s] == 0)
+      continue;
+    header.offsets[s] = offset;
+    offset += (bytes[s] + page_size - 1) / page_size * page_size;
+  }
+  header.file_size = offset;
+
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  if (!out)
+    throw std::runtime_error("cannot create " + path);
+  std::vector<char> padding(page_size, 0);
+  out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  out.write(padding.data(), page_size - sizeof(header));
+  for (int s = 0; s < num_sections; s++) {
+    if (bytes[s] == 0)
+      continue;
+    out.write(static_cast<const char *>(data[s]), bytes[s]);
+    out.write(padding.data(), (page_size - bytes[s] % page_size) % page_size);
+  }
+  if (!out)
+    throw std::runtime_error("failed writing " + path);
+}
+
+inline void save_lapper(const Lapper &lapper, const std::string &path) {
+  save_lapper(lapper.view(), path);
+}
+
+// A Lapper file opened in place. Queries run directly on the mapped pages;
+// the mapping lives as long as this object.
+class MappedLapper {
+private:
+  MappedFile file;
+  LapperView v;
+
+  template <typename T> const T *section(const LapperFileHeader &h, int s) {
+    return reinterpret_cast<const T *>(file.data() + h.offsets[s]);
+  }
+
+  // Bytes section s must hold for the header's length and num_classes,
+  // which check_layout has already bounded so this cannot overflow.
+  static size_t section_bytes(const LapperFileHeader &h, int s) {
+    using namespace lapper_io;
+    if (s == section_classes)
+      return sizeof(LengthClass) * h.num_classes;
+    if (s == section_starts_sorted && h.num_classes <= 1)
+      return 0;
+    return 4 * h.length;
+  }
+
+  static void check_layout(const LapperFileHeader &h, const std::string &path) {
+    using namespace lapper_io;
+    auto corrupt = [&](const std::string &what) {
+      return std::runtime_error(path + ": corrupt Lapper file (" + what + ")");
+    };
+    if (h.length > h.file_size / 4 ||
+        h.num_classes > h.file_size / sizeof(LengthClass))
+      throw corrupt("length out of range");
+    for (int s = 0; s < num_sections; s++) {
+      size_t bytes = section_bytes(h, s);
+      if (bytes == 0)
+        continue;
+      if (h.offsets[s] < page_size || h.offsets[s] % page_size != 0)
+        throw corrupt("misaligned section");
+      if (h.offsets[s] > h.file_size || bytes > h.file_size - h.offsets[s])
+        throw corrupt("section past end of file");
+    }
+  }
+
+  // The classes must tile [0, length) in order, as Lapper builds them; queries
+  // index the columns through them unchecked.
+  static void check_classes(const LengthClass *classes, size_t num_classes,
+                            size_t length, const std::string &path) {
+    size_t next = 0;
+    for (size_t k = 0; k < num_classes; k++) {
+      if (classes[k].offset != next || classes[k].length > length - next)
+        throw std::runtime_error(path +
+                                 ": corrupt Lapper file (length class out of "
+                                 "range)");
+      next += classes[k].length;
+    }
+    if (next != length)
+      throw std::runtime_error(
+          path + ": corrupt Lapper file (length classes do not cover rows)");
+  }
+
+public:
+  explicit MappedLapper(const std::string &path) : file(path) {
+    using namespace lapper_io;
+    LapperFileHeader h;
+    if (file.size() < page_size)
+      throw std::runtime_error(path + ": not a Lapper file");
+    std::memcpy(&h, file.data(), sizeof(h));
+    if (std::memcmp(h.magic, magic, sizeof(magic)) != 0)
+      throw std::runtime_error(path + ": not a Lapper file");
+    if (h.byte_order_mark != byte_order_mark)
+      throw std::runtime_error(path + ": written with a different byte order");
+    if (h.version != version)
+      throw std::runtime_error(path + ": unsupported Lapper file version " +
+                               std::to_string(h.version));
+    if (h.file_size != file.size())
+      throw std::runtime_error(path + ": truncated Lapper file");
+    check_layout(h, path);
+
+    v.starts = section<uint32_t>(h, section_starts);
+    v.stops = section<uint32_t>(h, section_stops);
+    v.vals = section<int32_t>(h, section_vals);
+    v.stops_sorted = section<uint32_t>(h, section_stops_sorted);
+    v.starts_sorted =
+        h.num_classes > 1 ? section<uint32_t>(h, section_starts_sorted) : v.starts;
+    v.classes = section<LengthClass>(h, section_classes);
+    check_classes(v.classes, h.num_classes, h.length, path);
+    v.num_classes = h.num_classes;
+    v.length = h.length;
+    v.max_len = h.max_len;
+  }
+
+  const LapperView &view() const { return v; }
+
+  void find(uint32_t start, uint32_t stop,
+            std::vector<Interval> &results) const {
+    v.find(start, stop, results);
+  }
+
+  size_t count(uint32_t start, uint32_t stop) const {
+    return v.count(start, stop);
+  }
+
+  size_t size() const { return v.length; }
+};
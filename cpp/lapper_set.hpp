@@ -0,0 +1,204 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "lapper.hpp"
+#include "parallel.hpp"
+
+struct ContigQuery {
+  uint32_t contig;
+  uint32_t start;
+  uint32_t stop;
+};
+
+// One Lapper per contig, with every contig's columns in a single arena.
+//
+// The arena holds five columns back to back: starts, stops, vals,
+// stops_sorted and starts_sorted, each being the concatenation of all contigs'
+// slices. A per-contig table records where each contig's slices begin, so a
+// query is a table lookup plus an ordinary LapperView query. The whole set is
+// three allocations (arena, length classes, contig table) no matter how many
+// contigs there are.
+class LapperSet {
+private:
+  struct Contig {
+    size_t row_offset;
+    size_t length;
+    size_t class_offset;
+    size_t num_classes;
+    // SIZE_MAX when the contig has a single length class.
+    size_t starts_sorted_offset;
+    uint32_t max_len;
+  };
+
+  std::vector<uint32_t> arena;
+  std::vector<LengthClass> classes;
+  std::vector<Contig> contigs;
+  std::vector<std::string> names;
+  std::unordered_map<std::string, uint32_t> ids;
+  size_t total_rows = 0;
+
+  uint32_t *column(int i) { return arena.data() + i * total_rows; }
+  const uint32_t *column(int i) const { return arena.data() + i * total_rows; }
+
+  void build(std::vector<std::vector<Interval>> &per_contig, bool split,
+             unsigned threads) {
+    size_t n = per_contig.size();
+    std::vector<size_t> order(n);
+    std::iota(order.begin(), order.end(), size_t(0));
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+      return per_contig[a].size() > per_contig[b].size();
+    });
+
+    // Sort and plan every contig, one contig per task. Within a task the sort
+    // is single threaded, the parallelism comes from the contigs.
+    std::vector<LengthClassPlan> plans(n, LengthClassPlan({}, split));
+    parallel_for_each(order, threads, [&](size_t c) {
+      sort_intervals(per_contig[c], 1);
+      plans[c] = LengthClassPlan(per_contig[c], split);
+    });
+
+    contigs.resize(n);
+    size_t num_classes = 0, num_starts_sorted = 0;
+    for (size_t c = 0; c < n; c++) {
+      contigs[c] = {total_rows,
+                    per_contig[c].size(),
+                    num_classes,
+                    plans[c].classes.size(),
+                    plans[c].needs_starts_sorted() ? num_starts_sorted
+                                                   : SIZE_MAX,
+                    plans[c].max_len};
+      total_rows += per_contig[c].size();
+      num_classes += plans[c].classes.size();
+      if (plans[c].needs_starts_sorted())
+        num_starts_sorted += per_contig[c].size();
+    }
+    arena.resize(4 * total_rows + num_starts_sorted);
+    classes.resize(num_classes);
+
+    parallel_for_each(order, threads, [&](size_t c) {
+      const Contig &meta = contigs[c];
+      uint32_t *starts_sorted =
+          meta.starts_sorted_offset == SIZE_MAX
+              ? nullptr
+              : column(4) + meta.starts_sorted_offset;
+      plans[c].scatter(per_contig[c], column(0) + meta.row_offset,
+                       column(1) + meta.row_offset,
+                       reinterpret_cast<int32_t *>(column(2)) + meta.row_offset,
+                       starts_sorted);
+      fill_stops_sorted(per_contig[c], column(3) + meta.row_offset, 1);
+      std::copy(plans[c].classes.begin(), plans[c].classes.end(),
+                classes.begin() + meta.class_offset);
+      std::vector<Interval>().swap(per_contig[c]);
+    });
+  }
+
+public:
+  // Builds one index per contig; per_contig[i] holds the intervals of contig
+  // id i. Contigs are built in parallel, biggest first.
+  explicit LapperSet(std::vector<std::vector<Interval>> per_contig,
+                     bool split_length_classes = true,
+                     unsigned threads = default_threads()) {
+    build(per_contig, split_length_classes, threads);
+  }
+
+  // As above, with a name per contig so ids can be looked up by name.
+  LapperSet(std::vector<std::string> contig_names,
+            std::vector<std::vector<Interval>> per_contig,
+            bool split_length_classes = true,
+            unsigned threads = default_threads())
+      : names(std::move(contig_names)) {
+    if (names.size() != per_contig.size())
+      throw std::invalid_argument("one contig name per contig is required");
+    for (size_t i = 0; i < names.size(); i++)
+      ids.emplace(names[i], uint32_t(i));
+    build(per_contig, split_length_classes, threads);
+  }
+
+  LapperView contig(uint32_t id) const {
+    const Contig &meta = contigs[id];
+    LapperView v;
+    v.starts = column(0) + meta.row_offset;
+    v.stops = column(1) + meta.row_offset;
+    v.vals = reinterpret_cast<const int32_t *>(column(2)) + meta.row_offset;
+    v.stops_sorted = column(3) + meta.row_offset;
+    v.starts_sorted = meta.starts_sorted_offset == SIZE_MAX
+                          ? v.starts
+                          : column(4) + meta.starts_sorted_offset;
+    v.classes = classes.data() + meta.class_offset;
+    v.num_classes = meta.num_classes;
+    v.length = meta.length;
+    v.max_len = meta.max_len;
+    return v;
+  }
+
+  // Id of a named contig, or -1 if the set has no contig of that name.
+  int64_t contig_id(const std::string &name) const {
+    auto it = ids.find(name);
+    return it == ids.end() ? -1 : int64_t(it->second);
+  }
+
+  const std::vector<std::string> &contig_names() const { return names; }
+
+  size_t num_contigs() const { return contigs.size(); }
+
+  size_t size() const { return total_rows; }
+
+  void find(uint32_t contig_id, uint32_t start, uint32_t stop,
+            std::vector<Interval> &results) const {
+    contig(contig_id).find(start, stop, results);
+  }
+
+  size_t count(uint32_t contig_id, uint32_t start, uint32_t stop) const {
+    return contig(contig_id).count(start, stop);
+  }
+
+  // out[i] = count(queries[i]). Queries may mix contigs freely.
+  void count_batch(const std::vector<ContigQuery> &queries,
+                   std::vector<size_t> &out,
+                   unsigned threads = default_threads()) const {
+    out.resize(queries.size());
+    parallel_chunks(queries.size(), threads,
+                    [&](unsigned, size_t begin, size_t end) {
+                      for (size_t i = begin; i < end; i++)
+                        out[i] = count(queries[i].contig, queries[i].start,
+                                       queries[i].stop);
+                    });
+  }
+
+  // Finds every query, results for query i are
+  // results[offsets[i], offsets[i + 1]). Queries may mix contigs freely.
+  void find_batch(const std::vector<ContigQuery> &queries,
+                  std::vector<Interval> &results, std::vector<size_t> &offsets,
+                  unsigned threads = default_threads()) const {
+    threads = std::max(1u, std::min<unsigned>(threads, queries.size()));
+    std::vector<std::vector<Interval>> chunk_results(threads);
+    offsets.assign(queries.size() + 1, 0);
+    parallel_chunks(queries.size(), threads,
+                    [&](unsigned t, size_t begin, size_t end) {
+                      for (size_t i = begin; i < end; i++) {
+                        find(queries[i].contig, queries[i].start,
+                             queries[i].stop, chunk_results[t]);
+                        offsets[i + 1] = chunk_results[t].size();
+                      }
+                    });
+
+    // Chunk-local end offsets become global ones.
+    results.clear();
+    for (unsigned t = 0; t < threads; t++) {
+      size_t base = results.size();
+      size_t begin = queries.size() * t / threads;
+      size_t end = queries.size() * (t + 1) / threads;
+      for (size_t i = begin; i < end; i++)
+        offsets[i + 1] += base;
+      results.insert(results.end(), chunk_results[t].begin(),
+                     chunk_results[t].end());
+    }
+  }
+};
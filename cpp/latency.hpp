@@ -0,0 +1,162 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Per-query latency measurement for the benchmarks: a timestamp counter
+// calibrated against steady_clock, and a log-bucketed histogram to record
+// into, so tails are reported instead of averaged away.
+
+// Reads the TSC with fences so the measured code cannot drift across either
+// stamp. Falls back to steady_clock nanoseconds off x86.
+class TscClock {
+public:
+    static uint64_t start() {
+#if defined(__x86_64__) || defined(__i386__)
+        _mm_lfence();
+        uint64_t t = __rdtsc();
+        _mm_lfence();
+        return t;
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    static uint64_t stop() {
+#if defined(__x86_64__) || defined(__i386__)
+        unsigned aux;
+        uint64_t t = __rdtscp(&aux);
+        _mm_lfence();
+        return t;
+#else
+        return start();
+#endif
+    }
+
+    // Ticks per nanosecond, from a ~20 ms busy wait against steady_clock.
+    double ticks_per_ns = 1;
+
+    TscClock() {
+        auto t0 = std::chrono::steady_clock::now();
+        uint64_t c0 = start();
+        auto t1 = t0;
+        while (t1 - t0 < std::chrono::milliseconds(20)) {
+            t1 = std::chrono::steady_clock::now();
+        }
+        uint64_t c1 = stop();
+        ticks_per_ns = (c1 - c0) / std::chrono::duration<double, std::nano>(t1 - t0).count();
+    }
+
+    double to_ns(double ticks) const { return ticks / ticks_per_ns; }
+};
+
+// HDR-style histogram of tick counts: exact below 32, then 32 linear
+// sub-buckets per power of two, so any recorded value is reported within
+// ~3% over the full 64-bit range.
+class LatencyHistogram {
+    static constexpr int sub_bits = 5;
+    static constexpr uint64_t sub_count = uint64_t(1) << sub_bits;
+
+    std::vector<uint64_t> counts = std::vector<uint64_t>((64 - sub_bits + 1) * sub_count, 0);
+    uint64_t total = 0;
+    uint64_t max_value = 0;
+
+    static size_t index(uint64_t v) {
+        if (v < sub_count) return v;
+        int msb = 63 - __builtin_clzll(v);
+        int shift = msb - sub_bits;
+        return (size_t)(shift + 1) * sub_count + ((v >> shift) - sub_count);
+    }
+
+    // Largest value that lands in bucket i.
+    static uint64_t upper(size_t i) {
+        if (i < sub_count) return i;
+        int shift = (int)(i / sub_count) - 1;
+        uint64_t low = (sub_count + i % sub_count) << shift;
+        return low + ((uint64_t(1) << shift) - 1);
+    }
+
+public:
+    void record(uint64_t ticks, uint64_t times = 1) {
+        counts[index(ticks)] += times;
+        total += times;
+        max_value = std::max(max_value, ticks);
+    }
+
+    uint64_t count() const { return total; }
+    uint64_t max() const { return max_value; }
+
+    // Smallest bucket bound at or below which p percent of samples fall.
+    uint64_t percentile(double p) const {
+        if (total == 0) return 0;
+        uint64_t rank = std::max<uint64_t>(1, (uint64_t)std::ceil(p / 100 * total));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < counts.size(); ++i) {
+            seen += counts[i];
+            if (seen >= rank) return std::min(upper(i), max_value);
+        }
+        return max_value;
+    }
+};
+
+// Times run_group(begin, end) over [0, n) in back-to-back groups of `group`
+// and records each group's ticks divided by its size, once per query. A
+// batched kernel gets the whole group in one call.
+template<typename RunGroup>
+void record_group_latency(LatencyHistogram& hist, RunGroup&& run_group, size_t n, size_t group) {
+    for (size_t begin = 0; begin < n; begin += group) {
+        size_t end = std::min(n, begin + group);
+        uint64_t t0 = TscClock::start();
+        run_group(begin, end);
+        uint64_t t1 = TscClock::stop();
+        hist.record((t1 - t0) / (end - begin), end - begin);
+    }
+}
+
+// record_group_latency for one query(i) at a time.
+template<typename Query>
+void record_latency(LatencyHistogram& hist, Query&& query, size_t n, size_t group) {
+    record_group_latency(hist, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            query(i);
+        }
+    }, n, group);
+}
+
+// Cost of an empty start/stop pair, which every recorded group includes.
+inline LatencyHistogram timer_overhead(size_t samples = 100000) {
+    LatencyHistogram hist;
+    for (size_t i = 0; i < samples; ++i) {
+        uint64_t t0 = TscClock::start();
+        uint64_t t1 = TscClock::stop();
+        hist.record(t1 - t0);
+    }
+    return hist;
+}
+
+inline void print_latency_header(int name_width) {
+    std::cout << std::setw(name_width) << "Algorithm" << std::setw(11) << "p50" << std::setw(11) << "p99"
+              << std::setw(11) << "p99.9" << std::setw(11) << "max" << "\n";
+    std::cout << std::setw(name_width) << "" << std::setw(44) << "(ns/query)" << "\n";
+    std::cout << std::string(name_width + 44, '-') << std::endl;
+}
+
+inline void print_latency_row(const std::string& name, int name_width, const LatencyHistogram& hist,
+                              const TscClock& clock) {
+    std::cout << std::setw(name_width) << name << std::fixed << std::setprecision(1)
+              << std::setw(11) << clock.to_ns(hist.percentile(50))
+              << std::setw(11) << clock.to_ns(hist.percentile(99))
+              << std::setw(11) << clock.to_ns(hist.percentile(99.9))
+              << std::setw(11) << clock.to_ns(hist.max()) << std::endl;
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Read-only mmap of a whole file, unmapped on destruction.
+class MappedFile {
+private:
+  const char *ptr = nullptr;
+  size_t len = 0;
+
+public:
+  explicit MappedFile(const std::string &path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      throw std::runtime_error("cannot open " + path);
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+      ::close(fd);
+      throw std::runtime_error("cannot stat " + path);
+    }
+    len = st.st_size;
+    if (len > 0) {
+      void *p = ::mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (p == MAP_FAILED) {
+        ::close(fd);
+        throw std::runtime_error("cannot mmap " + path);
+      }
+      ptr = static_cast<const char *>(p);
+    }
+    ::close(fd);
+  }
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  ~MappedFile() {
+    if (ptr)
+      ::munmap(const_cast<char *>(ptr), len);
+  }
+
+  // Hints the kernel about the coming access pattern, e.g. MADV_SEQUENTIAL.
+  void advise(int advice) const {
+    if (ptr)
+      ::madvise(const_cast<char *>(ptr), len, advice);
+  }
+
+  const char *data() const { return ptr; }
+
+  size_t size() const { return len; }
+};
@@ -0,0 +1,278 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "lapper.hpp"
+#include "parallel.hpp"
+
+// Closest and k-nearest interval queries over a LapperView.
+//
+// Distance is the number of coordinates strictly between query and interval:
+// 0 when they overlap or touch, start - iv.stop for an upstream interval and
+// iv.start - stop for a downstream one. Whether a neighbor lies upstream or
+// downstream follows from comparing its coordinates with the query.
+//
+// The gap on each side comes straight from stops_sorted and starts_sorted in
+// O(log n). Recovering the intervals themselves walks the length-class
+// slices, where each class's max_len bounds how far back an upstream
+// interval can start.
+template <typename Coord, typename Val> struct BasicNeighbor {
+  BasicInterval<Coord, Val> interval;
+  Coord distance;
+};
+
+using Neighbor = BasicNeighbor<uint32_t, int32_t>;
+
+namespace nearest_detail {
+
+// Upper bound on the number of length classes, one per length bit width, so
+// per-class cursors fit on the stack.
+template <typename Coord>
+constexpr size_t max_classes = std::numeric_limits<Coord>::digits + 1;
+
+// Yields the non-overlapping rows that stop at or before `start`, latest stop
+// first. Each class is walked backwards from `start`; a candidate is only
+// released once no unread row of any class could stop later.
+template <typename Coord, typename Val> class UpstreamCursor {
+private:
+  const BasicLapperView<Coord, Val> &v;
+  Coord start;
+  // One past the next row to read, per class.
+  size_t pos[max_classes<Coord>];
+  std::vector<size_t> heap;
+
+  bool later(size_t x, size_t y) const { return v.stops[x] < v.stops[y]; }
+
+  // Latest stop any unread row of class k could have.
+  bool bound(size_t k, Coord &out) const {
+    const BasicLengthClass<Coord> &c = v.classes[k];
+    if (pos[k] == c.offset)
+      return false;
+    Coord s = v.starts[pos[k] - 1];
+    out = s + std::min<Coord>(c.max_len, start - s);
+    return true;
+  }
+
+public:
+  UpstreamCursor(const BasicLapperView<Coord, Val> &v, Coord start)
+      : v(v), start(start) {
+    for (size_t k = 0; k < v.num_classes; k++) {
+      const BasicLengthClass<Coord> &c = v.classes[k];
+      pos[k] = c.offset + upper_bound_index(v.starts + c.offset, c.length, start);
+    }
+  }
+
+  // Next row, or SIZE_MAX when there is none.
+  size_t peek() {
+    auto cmp = [&](size_t x, size_t y) { return later(x, y); };
+    while (true) {
+      size_t best = SIZE_MAX;
+      Coord best_bound = 0;
+      for (size_t k = 0; k < v.num_classes; k++) {
+        Coord b;
+        if (bound(k, b) && (best == SIZE_MAX || b > best_bound)) {
+          best = k;
+          best_bound = b;
+        }
+      }
+      if (!heap.empty() &&
+          (best == SIZE_MAX || v.stops[heap.front()] >= best_bound))
+        return heap.front();
+      if (best == SIZE_MAX)
+        return SIZE_MAX;
+      size_t row = --pos[best];
+      if (v.stops[row] <= start) {
+        heap.push_back(row);
+        std::push_heap(heap.begin(), heap.end(), cmp);
+      }
+    }
+  }
+
+  void pop() {
+    auto cmp = [&](size_t x, size_t y) { return later(x, y); };
+    std::pop_heap(heap.begin(), heap.end(), cmp);
+    heap.pop_back();
+  }
+};
+
+// Yields the rows that start at or after `stop`, earliest start first. Rows
+// that also stop at or before `start`, which can only be empty intervals at
+// an empty query's position, belong to the upstream side and are skipped.
+template <typename Coord, typename Val> class DownstreamCursor {
+private:
+  const BasicLapperView<Coord, Val> &v;
+  Coord start;
+  size_t pos[max_classes<Coord>];
+  size_t end[max_classes<Coord>];
+
+public:
+  DownstreamCursor(const BasicLapperView<Coord, Val> &v, Coord start,
+                   Coord stop)
+      : v(v), start(start) {
+    for (size_t k = 0; k < v.num_classes; k++) {
+      const BasicLengthClass<Coord> &c = v.classes[k];
+      pos[k] = c.offset + lower_bound_index(v.starts + c.offset, c.length, stop);
+      end[k] = c.offset + c.length;
+      while (pos[k] < end[k] && v.stops[pos[k]] <= start)
+        pos[k]++;
+    }
+  }
+
+  // Next row, or SIZE_MAX when there is none.
+  size_t peek() const {
+    size_t best = SIZE_MAX;
+    for (size_t k = 0; k < v.num_classes; k++) {
+      if (pos[k] < end[k] &&
+          (best == SIZE_MAX || v.starts[pos[k]] < v.starts[pos[best]]))
+        best = k;
+    }
+    return best == SIZE_MAX ? SIZE_MAX : pos[best];
+  }
+
+  void pop(size_t row) {
+    for (size_t k = 0; k < v.num_classes; k++) {
+      // An exhausted slice's position is the next slice's first row.
+      if (pos[k] == row && pos[k] < end[k]) {
+        pos[k]++;
+        while (pos[k] < end[k] && v.stops[pos[k]] <= start)
+          pos[k]++;
+        return;
+      }
+    }
+  }
+};
+
+template <typename Coord, typename Val>
+BasicNeighbor<Coord, Val> neighbor(const BasicLapperView<Coord, Val> &v,
+                                   size_t i, Coord distance) {
+  return {{v.starts[i], v.stops[i], v.vals[i]}, distance};
+}
+
+} // namespace nearest_detail
+
+// Appends the intervals closest to [start, stop): every overlapping interval
+// if there are any, otherwise every interval at the smallest distance on
+// either side, upstream ones first.
+template <typename Coord, typename Val>
+void closest(const BasicLapperView<Coord, Val> &v, Coord start, Coord stop,
+             std::vector<BasicNeighbor<Coord, Val>> &out) {
+  using nearest_detail::neighbor;
+  size_t before = out.size();
+  v.for_each_overlap(start, stop,
+                     [&](size_t i) { out.push_back(neighbor(v, i, Coord(0))); });
+  if (out.size() > before || v.length == 0)
+    return;
+
+  // No overlaps, so everything stops at or before start or starts at or
+  // after stop.
+  size_t up = upper_bound_index(v.stops_sorted, v.length, start);
+  size_t down = lower_bound_index(v.starts_sorted, v.length, stop);
+  Coord up_stop = up > 0 ? v.stops_sorted[up - 1] : 0;
+  Coord down_start = down < v.length ? v.starts_sorted[down] : 0;
+  bool use_up = up > 0 && (down == v.length ||
+                           start - up_stop <= down_start - stop);
+  bool use_down = down < v.length &&
+                  (up == 0 || down_start - stop <= start - up_stop);
+
+  for (size_t k = 0; k < v.num_classes && use_up; k++) {
+    const BasicLengthClass<Coord> &c = v.classes[k];
+    size_t i = c.offset + lower_bound_index(v.starts + c.offset, c.length,
+                                            saturating_sub(up_stop, c.max_len));
+    for (; i < c.offset + c.length && v.starts[i] <= up_stop; i++) {
+      if (v.stops[i] == up_stop)
+        out.push_back(neighbor(v, i, Coord(start - up_stop)));
+    }
+  }
+  for (size_t k = 0; k < v.num_classes && use_down; k++) {
+    const BasicLengthClass<Coord> &c = v.classes[k];
+    size_t i = c.offset +
+               lower_bound_index(v.starts + c.offset, c.length, down_start);
+    for (; i < c.offset + c.length && v.starts[i] == down_start; i++) {
+      // An empty interval at an empty query's position is on both sides;
+      // it was reported as upstream.
+      if (v.stops[i] > start)
+        out.push_back(neighbor(v, i, Coord(down_start - stop)));
+    }
+  }
+}
+
+// Appends the k intervals nearest to [start, stop) in order of distance.
+// Overlapping intervals come first; on equal distance upstream intervals come
+// before downstream ones. Fewer than k only if the index is smaller than k.
+template <typename Coord, typename Val>
+void nearest(const BasicLapperView<Coord, Val> &v, Coord start, Coord stop,
+             size_t k, std::vector<BasicNeighbor<Coord, Val>> &out) {
+  using nearest_detail::neighbor;
+  size_t target = out.size() + k;
+  for (size_t c = 0; c < v.num_classes && out.size() < target; c++) {
+    const BasicLengthClass<Coord> &lc = v.classes[c];
+    size_t i = lc.offset + lower_bound_index(v.starts + lc.offset, lc.length,
+                                             saturating_sub(start, lc.max_len));
+    for (; i < lc.offset + lc.length && v.starts[i] < stop &&
+           out.size() < target;
+         i++) {
+      if (BasicInterval<Coord, Val>::overlap(v.starts[i], v.stops[i], start,
+                                             stop))
+        out.push_back(neighbor(v, i, Coord(0)));
+    }
+  }
+
+  nearest_detail::UpstreamCursor<Coord, Val> up(v, start);
+  nearest_detail::DownstreamCursor<Coord, Val> down(v, start, stop);
+  while (out.size() < target) {
+    size_t u = up.peek(), d = down.peek();
+    if (u == SIZE_MAX && d == SIZE_MAX)
+      break;
+    if (d == SIZE_MAX ||
+        (u != SIZE_MAX && start - v.stops[u] <= v.starts[d] - stop)) {
+      out.push_back(neighbor(v, u, Coord(start - v.stops[u])));
+      up.pop();
+    } else {
+      out.push_back(neighbor(v, d, Coord(v.starts[d] - stop)));
+      down.pop(d);
+    }
+  }
+}
+
+// The k intervals nearest to the single position pos, i.e. [pos, pos + 1).
+template <typename Coord, typename Val>
+void nearest(const BasicLapperView<Coord, Val> &v, Coord pos, size_t k,
+             std::vector<BasicNeighbor<Coord, Val>> &out) {
+  nearest(v, pos, Coord(pos + 1), k, out);
+}
+
+// nearest(pos, k) for many positions. Results for positions[i] are
+// results[offsets[i], offsets[i + 1]).
+template <typename Coord, typename Val>
+void nearest_batch(const BasicLapperView<Coord, Val> &v,
+                   const std::vector<Coord> &positions, size_t k,
+                   std::vector<BasicNeighbor<Coord, Val>> &results,
+                   std::vector<size_t> &offsets,
+                   unsigned threads = default_threads()) {
+  threads = std::max(1u, std::min<unsigned>(threads, positions.size()));
+  std::vector<std::vector<BasicNeighbor<Coord, Val>>> chunk_results(threads);
+  offsets.assign(positions.size() + 1, 0);
+  parallel_chunks(positions.size(), threads,
+                  [&](unsigned t, size_t begin, size_t end) {
+                    chunk_results[t].reserve((end - begin) * k);
+                    for (size_t i = begin; i < end; i++) {
+                      nearest(v, positions[i], k, chunk_results[t]);
+                      offsets[i + 1] = chunk_results[t].size();
+                    }
+                  });
+
+  // Chunk-local end offsets become global ones.
+  results.clear();
+  for (unsigned t = 0; t < threads; t++) {
+    size_t base = results.size();
+    size_t begin = positions.size() * t / threads;
+    size_t end = positions.size() * (t + 1) / threads;
+    for (size_t i = begin; i < end; i++)
+      offsets[i + 1] += base;
+    results.insert(results.end(), chunk_results[t].begin(),
+                   chunk_results[t].end());
+  }
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+inline unsigned default_threads() {
+  unsigned t = std::thread::hardware_concurrency();
+  return t ? t : 1;
+}
+
+// Splits [0, n) into `threads` contiguous chunks and runs f(t, begin, end) for
+// each on its own thread. Chunk t always covers the same range for a given n
+// and thread count, so callers can do two passes with matching chunks.
+template <typename F> void parallel_chunks(size_t n, unsigned threads, F &&f) {
+  threads = std::max(1u, std::min<unsigned>(threads, n ? n : 1));
+  if (threads == 1) {
+    f(0u, size_t(0), n);
+    return;
+  }
+  std::vector<std::thread> pool;
+  pool.reserve(threads - 1);
+  for (unsigned t = 1; t < threads; t++)
+    pool.emplace_back([&, t] { f(t, n * t / threads, n * (t + 1) / threads); });
+  f(0u, size_t(0), n / threads);
+  for (std::thread &th : pool)
+    th.join();
+}
+
+// Runs f(i) for every i in [0, n) on `threads` threads, handing out indices
+// one at a time in `order`. Useful when items differ wildly in cost, e.g. one
+// per contig: pass the biggest first.
+template <typename F>
+void parallel_for_each(const std::vector<size_t> &order, unsigned threads,
+                       F &&f) {
+  std::atomic<size_t> next{0};
+  parallel_chunks(order.size(), threads, [&](unsigned, size_t, size_t) {
+    for (size_t i; (i = next.fetch_add(1)) < order.size();)
+      f(order[i]);
+  });
+}
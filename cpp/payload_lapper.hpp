@@ -0,0 +1,118 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "lapper.hpp"
+
+// Column-oriented payload table: one vector per column, rows addressed by a
+// 32-bit row id. Holds the data that is only needed once an interval has
+// matched, such as gene ids, strand or scores.
+template <typename... Columns> class ColumnStore {
+  static_assert(sizeof...(Columns) > 0, "a ColumnStore needs a column");
+
+private:
+  std::tuple<std::vector<Columns>...> columns;
+
+  template <size_t... K>
+  void push(std::index_sequence<K...>, Columns &&...values) {
+    (std::get<K>(columns).push_back(std::move(values)), ...);
+  }
+
+  template <size_t... K>
+  std::tuple<Columns...> get_row(std::index_sequence<K...>,
+                                 uint32_t row) const {
+    return {std::get<K>(columns)[row]...};
+  }
+
+public:
+  // Appends a row and returns its row id.
+  uint32_t append(Columns... values) {
+    uint32_t row = uint32_t(size());
+    push(std::index_sequence_for<Columns...>(), std::move(values)...);
+    return row;
+  }
+
+  void reserve(size_t n) {
+    std::apply([&](auto &...column) { (column.reserve(n), ...); }, columns);
+  }
+
+  size_t size() const { return std::get<0>(columns).size(); }
+
+  template <size_t K> const auto &column() const {
+    return std::get<K>(columns);
+  }
+
+  template <size_t K> const auto &get(uint32_t row) const {
+    return std::get<K>(columns)[row];
+  }
+
+  std::tuple<Columns...> row(uint32_t row) const {
+    return get_row(std::index_sequence_for<Columns...>(), row);
+  }
+
+  // out[i] = column K of rows[i]. Only the listed rows are touched.
+  template <size_t K, typename T>
+  void gather(const std::vector<uint32_t> &rows, std::vector<T> &out) const {
+    const auto &column = std::get<K>(columns);
+    out.resize(rows.size());
+    for (size_t i = 0; i < rows.size(); i++)
+      out[i] = column[rows[i]];
+  }
+};
+
+// A Lapper over arbitrary payloads, split hot and cold.
+//
+// The index only holds starts, stops and a 32-bit row id per interval, so
+// find scans and counts never pull payload bytes into cache. Payload columns
+// live in a ColumnStore and are read only for the rows a query returns,
+// either eagerly with ColumnStore::gather or one by one through get.
+//
+// Several intervals may share a row, e.g. the exons of one transcript.
+template <typename... Columns> class PayloadLapper {
+public:
+  using Store = ColumnStore<Columns...>;
+
+private:
+  RowLapper index;
+  Store store;
+
+public:
+  // Each interval's val is the id of its row in payloads.
+  PayloadLapper(std::vector<RowInterval> intervals, Store payloads,
+                bool split_length_classes = true)
+      : index(checked(std::move(intervals), payloads), split_length_classes),
+        store(std::move(payloads)) {}
+
+  // Appends the row id of every interval overlapping [start, stop) to rows,
+  // in RowLapper::find order.
+  void find_rows(uint32_t start, uint32_t stop,
+                 std::vector<uint32_t> &rows) const {
+    index.find_vals(start, stop, rows);
+  }
+
+  size_t count(uint32_t start, uint32_t stop) const {
+    return index.count(start, stop);
+  }
+
+  size_t size() const { return index.size(); }
+
+  const RowLapper &intervals() const { return index; }
+
+  const Store &payloads() const { return store; }
+
+private:
+  static std::vector<RowInterval> checked(std::vector<RowInterval> intervals,
+                                          const Store &payloads) {
+    for (const RowInterval &iv : intervals) {
+      if (iv.val >= payloads.size())
+        throw std::invalid_argument("row id " + std::to_string(iv.val) +
+                                    " is past the end of the payload store");
+    }
+    return intervals;
+  }
+};
@@ -0,0 +1,122 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Hardware performance counters around a measured region, via
+// perf_event_open(2). Each event is opened on its own, so a PMU or kernel
+// that lacks one event (dTLB misses are the usual casualty in VMs) only
+// loses that column. When none can be opened, e.g. under a restrictive
+// perf_event_paranoid or in a container, available() is false and callers
+// report timing only.
+class PerfCounters {
+public:
+    enum Event { cycles, instructions, l1d_misses, llc_misses, dtlb_misses, branch_misses, num_events };
+
+    struct Reading {
+        // Scaled for multiplexing; -1 when the event is unavailable.
+        double values[num_events];
+    };
+
+    static const char* name(int e) {
+        static const char* names[num_events] = {"cycles", "instr", "L1D-miss", "LLC-miss", "dTLB-miss",
+                                                "br-miss"};
+        return names[e];
+    }
+
+    PerfCounters() {
+        for (int e = 0; e < num_events; ++e) {
+            fds[e] = open_event(e);
+        }
+    }
+
+    ~PerfCounters() {
+        for (int fd : fds) {
+            if (fd >= 0) close(fd);
+        }
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool available() const {
+        for (int fd : fds) {
+            if (fd >= 0) return true;
+        }
+        return false;
+    }
+
+    bool available(int e) const { return fds[e] >= 0; }
+
+    void start() {
+        for (int fd : fds) {
+            if (fd < 0) continue;
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+
+    Reading stop() {
+        for (int fd : fds) {
+            if (fd >= 0) ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        }
+        Reading r;
+        for (int e = 0; e < num_events; ++e) {
+            r.values[e] = -1;
+            uint64_t buf[3]; // value, time enabled, time running
+            if (fds[e] < 0 || read(fds[e], buf, sizeof(buf)) != (ssize_t)sizeof(buf)) continue;
+            r.values[e] = buf[2] == 0 ? 0 : (double)buf[0] * buf[1] / buf[2];
+        }
+        return r;
+    }
+
+private:
+    int fds[num_events];
+
+    static uint64_t cache_config(uint64_t cache, uint64_t op, uint64_t result) {
+        return cache | (op << 8) | (result << 16);
+    }
+
+    static int open_event(int e) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        switch (e) {
+        case cycles:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+        case instructions:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+        case l1d_misses:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = cache_config(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ,
+                                       PERF_COUNT_HW_CACHE_RESULT_MISS);
+            break;
+        case llc_misses:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CACHE_MISSES;
+            break;
+        case dtlb_misses:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = cache_config(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ,
+                                       PERF_COUNT_HW_CACHE_RESULT_MISS);
+            break;
+        case branch_misses:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+            break;
+        }
+        return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+};
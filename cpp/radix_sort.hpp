@@ -0,0 +1,122 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <type_traits>
+#include <vector>
+
+#include "parallel.hpp"
+
+// Parallel LSD radix sort over 32 or 64-bit integer keys, 8 bits per pass.
+// Signed keys are handled by flipping the sign bit when extracting digits.
+//
+// Each pass histograms its thread's chunk, turns the histograms into
+// bucket-major, thread-minor offsets and scatters, which keeps the sort
+// stable. Passes where every key has the same digit (e.g. the high bytes of
+// small coordinates) are skipped.
+namespace radix_detail {
+
+constexpr int digit_bits = 8;
+constexpr size_t num_buckets = size_t(1) << digit_bits;
+// Below this many keys the thread startup costs more than the sort.
+constexpr size_t min_parallel = size_t(1) << 16;
+
+template <typename Key> struct Digits {
+  using U = typename std::make_unsigned<Key>::type;
+  static constexpr U flip =
+      std::is_signed<Key>::value ? U(1) << (sizeof(Key) * 8 - 1) : U(0);
+
+  static size_t at(Key key, int shift) {
+    return ((U(key) ^ flip) >> shift) & (num_buckets - 1);
+  }
+};
+
+template <typename Key, typename Payload>
+void sort(Key *keys, Payload *payload, size_t n, unsigned threads) {
+  static_assert(std::is_integral<Key>::value, "radix_sort needs integer keys");
+  if (n < 2)
+    return;
+  // parallel_chunks runs at least one chunk, so hist needs at least one row.
+  threads = n < min_parallel ? 1 : std::max(1u, threads);
+
+  std::vector<Key> key_buf(n);
+  std::vector<Payload> payload_buf(payload ? n : 0);
+  std::vector<std::array<size_t, num_buckets>> hist(threads);
+  Key *src = keys, *dst = key_buf.data();
+  Payload *payload_src = payload, *payload_dst = payload_buf.data();
+
+  for (int shift = 0; shift < int(sizeof(Key) * 8); shift += digit_bits) {
+    parallel_chunks(n, threads, [&](unsigned t, size_t begin, size_t end) {
+      hist[t].fill(0);
+      for (size_t i = begin; i < end; i++)
+        hist[t][Digits<Key>::at(src[i], shift)]++;
+    });
+
+    bool trivial = false;
+    size_t offset = 0;
+    for (size_t b = 0; b < num_buckets; b++) {
+      size_t bucket_total = 0;
+      for (unsigned t = 0; t < threads; t++) {
+        size_t c = hist[t][b];
+        hist[t][b] = offset;
+        offset += c;
+        bucket_total += c;
+      }
+      trivial |= bucket_total == n;
+    }
+    if (trivial)
+      continue;
+
+    parallel_chunks(n, threads, [&](unsigned t, size_t begin, size_t end) {
+      std::array<size_t, num_buckets> &pos = hist[t];
+      for (size_t i = begin; i < end; i++) {
+        size_t d = pos[Digits<Key>::at(src[i], shift)]++;
+        dst[d] = src[i];
+        if (payload)
+          payload_dst[d] = payload_src[i];
+      }
+    });
+    std::swap(src, dst);
+    std::swap(payload_src, payload_dst);
+  }
+
+  // An odd number of scatter passes leaves the result in the buffers.
+  if (src != keys) {
+    std::copy(src, src + n, keys);
+    if (payload)
+      std::copy(payload_src, payload_src + n, payload);
+  }
+}
+
+} // namespace radix_detail
+
+// Sorts keys[0, n) ascending.
+template <typename Key>
+void radix_sort(Key *keys, size_t n, unsigned threads = default_threads()) {
+  radix_detail::sort<Key, uint32_t>(keys, nullptr, n, threads);
+}
+
+template <typename Key>
+void radix_sort(std::vector<Key> &keys, unsigned threads = default_threads()) {
+  radix_sort(keys.data(), keys.size(), threads);
+}
+
+// Sorts keys ascending and applies the same permutation to payload. Equal
+// keys keep their input order.
+template <typename Key, typename Payload>
+void radix_sort(std::vector<Key> &keys, std::vector<Payload> &payload,
+                unsigned threads = default_threads()) {
+  radix_detail::sort(keys.data(), payload.data(), keys.size(), threads);
+}
+
+// Returns the permutation that sorts keys, keys are sorted in place.
+template <typename Key>
+std::vector<uint32_t> radix_argsort(std::vector<Key> &keys,
+                                    unsigned threads = default_threads()) {
+  std::vector<uint32_t> perm(keys.size());
+  std::iota(perm.begin(), perm.end(), 0u);
+  radix_sort(keys, perm, threads);
+  return perm;
+}
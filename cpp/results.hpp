@@ -0,0 +1,174 @@
+#pragma once
+#include <cstddef>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Machine-readable benchmark results. Every measurement is one record, in
+// long form: (algorithm, n, distribution, threads, trials, statistic,
+// value). Records are written as CSV, with the run metadata as leading
+// "# key: value" comments, or as JSON. compare_results.cpp reads the CSV.
+
+#ifndef BENCH_CXXFLAGS
+#define BENCH_CXXFLAGS "unknown"
+#endif
+
+struct ResultRecord {
+    std::string algorithm;
+    size_t n = 0;
+    std::string distribution;
+    unsigned threads = 1;
+    int trials = 0;
+    std::string statistic;
+    double value = 0;
+};
+
+// CPU model, compiler and flags of this build and machine.
+inline std::map<std::string, std::string> run_metadata() {
+    std::map<std::string, std::string> meta;
+    meta["cpu"] = "unknown";
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    for (std::string line; std::getline(cpuinfo, line);) {
+        if (line.rfind("model name", 0) == 0 && line.find(':') != std::string::npos) {
+            meta["cpu"] = line.substr(line.find(':') + 2);
+            break;
+        }
+    }
+#if defined(__clang__)
+    meta["compiler"] = "clang " __clang_version__;
+#elif defined(__GNUC__)
+    meta["compiler"] = "gcc " __VERSION__;
+#else
+    meta["compiler"] = "unknown";
+#endif
+    meta["flags"] = BENCH_CXXFLAGS;
+    return meta;
+}
+
+class ResultWriter {
+    std::map<std::string, std::string> meta = run_metadata();
+    std::vector<ResultRecord> records;
+
+    static std::string csv_field(const std::string& s) {
+        if (s.find_first_of(",\"\n") == std::string::npos) return s;
+        std::string out = "\"";
+        for (char c : s) {
+            if (c == '"') out += '"';
+            out += c;
+        }
+        return out + "\"";
+    }
+
+    static std::string json_string(const std::string& s) {
+        std::string out = "\"";
+        for (char c : s) {
+            if (c == '"' || c == '\\') {
+                out += '\\';
+                out += c;
+            } else if ((unsigned char)c < 0x20) {
+                std::ostringstream esc;
+                esc << "\\u" << std::hex << std::setw(4) << std::setfill('0') << (int)c;
+                out += esc.str();
+            } else {
+                out += c;
+            }
+        }
+        return out + "\"";
+    }
+
+    static std::ofstream open(const std::string& path) {
+        std::ofstream out(path);
+        if (!out) throw std::runtime_error("cannot write " + path);
+        out << std::setprecision(10);
+        return out;
+    }
+
+public:
+    void set_metadata(const std::string& key, const std::string& value) { meta[key] = value; }
+
+    void add(const ResultRecord& record) { records.push_back(record); }
+
+    void write_csv(const std::string& path) const {
+        std::ofstream out = open(path);
+        for (const auto& [key, value] : meta) {
+            out << "# " << key << ": " << value << "\n";
+        }
+        out << "algorithm,n,distribution,threads,trials,statistic,value\n";
+        for (const ResultRecord& r : records) {
+            out << csv_field(r.algorithm) << "," << r.n << "," << csv_field(r.distribution) << "," << r.threads
+                << "," << r.trials << "," << csv_field(r.statistic) << "," << r.value << "\n";
+        }
+    }
+
+    void write_json(const std::string& path) const {
+        std::ofstream out = open(path);
+        out << "{\n  \"metadata\": {";
+        const char* sep = "\n";
+        for (const auto& [key, value] : meta) {
+            out << sep << "    " << json_string(key) << ": " << json_string(value);
+            sep = ",\n";
+        }
+        out << "\n  },\n  \"results\": [";
+        sep = "\n";
+        for (const ResultRecord& r : records) {
+            out << sep << "    {\"algorithm\": " << json_string(r.algorithm) << ", \"n\": " << r.n
+                << ", \"distribution\": " << json_string(r.distribution) << ", \"threads\": " << r.threads
+                << ", \"trials\": " << r.trials << ", \"statistic\": " << json_string(r.statistic)
+                << ", \"value\": " << r.value << "}";
+            sep = ",\n";
+        }
+        out << "\n  ]\n}\n";
+    }
+};
+
+// Reads records back from write_csv's format, skipping comments. Metadata
+// comments land in meta when it is given.
+inline std::vector<ResultRecord> read_results_csv(const std::string& path,
+                                                  std::map<std::string, std::string>* meta = nullptr) {
+    std::ifstream in(path);
+    if (!in) throw std::runtime_error("cannot read " + path);
+    std::vector<ResultRecord> records;
+    bool header = true;
+    for (std::string line; std::getline(in, line);) {
+        if (line.rfind("# ", 0) == 0) {
+            size_t colon = line.find(": ");
+            if (meta && colon != std::string::npos) (*meta)[line.substr(2, colon - 2)] = line.substr(colon + 2);
+            continue;
+        }
+        if (line.empty()) continue;
+        if (header) {
+            header = false;
+            continue;
+        }
+        std::vector<std::string> fields(1);
+        bool quoted = false;
+        for (size_t i = 0; i < line.size(); ++i) {
+            char c = line[i];
+            if (quoted && c == '"' && i + 1 < line.size() && line[i + 1] == '"') {
+                fields.back() += '"';
+                ++i;
+            } else if (c == '"') {
+                quoted = !quoted;
+            } else if (c == ',' && !quoted) {
+                fields.emplace_back();
+            } else {
+                fields.back() += c;
+            }
+        }
+        if (fields.size() != 7) throw std::runtime_error("malformed line in " + path + ": " + line);
+        ResultRecord r;
+        r.algorithm = fields[0];
+        r.n = std::stoull(fields[1]);
+        r.distribution = fields[2];
+        r.threads = (unsigned)std::stoul(fields[3]);
+        r.trials = std::stoi(fields[4]);
+        r.statistic = fields[5];
+        r.value = std::stod(fields[6]);
+        records.push_back(r);
+    }
+    return records;
+}
@@ -0,0 +1,251 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "lapper.hpp"
+#include "parallel.hpp"
+
+// Set algebra on Lappers: merge_overlaps, intersect, subtract, complement.
+//
+// A Lapper is read as the set of coordinates its intervals cover, so results
+// are disjoint, maximal intervals: overlapping and touching intervals merge
+// ([10,20) and [20,30) become [10,30)), and empty intervals cover nothing.
+// Result vals are Val{}.
+//
+// Each input is streamed as its union in start order, straight from the
+// sorted columns, and the operation is a linear merge of those streams. The
+// output is already sorted and becomes a Lapper through from_sorted, with no
+// sort. With several threads the coordinate space is cut at quantiles of the
+// first input's starts and every range is swept independently; pieces that
+// meet at a cut are joined back together.
+namespace set_ops_detail {
+
+// Yields the union of a view's intervals within [lo, hi) as disjoint,
+// non-touching segments in order. Rows that start before lo but reach past it
+// are folded into the first segment.
+template <typename Coord, typename Val> class UnionCursor {
+private:
+  const BasicLapperView<Coord, Val> &v;
+  StartOrderCursor<Coord, Val> cursor;
+  Coord hi;
+  bool unbounded;
+  bool pending = false;
+  Coord pending_start = 0, pending_stop = 0;
+
+public:
+  UnionCursor(const BasicLapperView<Coord, Val> &v, Coord lo, Coord hi,
+              bool unbounded)
+      : v(v), cursor(v, lo, hi, unbounded), hi(hi), unbounded(unbounded) {
+    for (size_t k = 0; k < v.num_classes; k++) {
+      const BasicLengthClass<Coord> &c = v.classes[k];
+      size_t i = c.offset + lower_bound_index(v.starts + c.offset, c.length,
+                                              saturating_sub(lo, c.max_len));
+      for (; i < c.offset + c.length && v.starts[i] < lo; i++) {
+        if (v.stops[i] > lo) {
+          pending_stop = pending ? std::max(pending_stop, v.stops[i])
+                                 : v.stops[i];
+          pending_start = lo;
+          pending = true;
+        }
+      }
+    }
+  }
+
+  bool next(Coord &start, Coord &stop) {
+    for (size_t row = cursor.peek(); row != SIZE_MAX; row = cursor.peek()) {
+      cursor.advance(row);
+      Coord s = v.starts[row], e = v.stops[row];
+      if (s == e)
+        continue;
+      if (pending && s <= pending_stop) {
+        pending_stop = std::max(pending_stop, e);
+        continue;
+      }
+      bool emit = pending;
+      start = pending_start;
+      stop = pending_stop;
+      pending = true;
+      pending_start = s;
+      pending_stop = e;
+      if (emit)
+        return clip(start, stop);
+    }
+    if (!pending)
+      return false;
+    pending = false;
+    start = pending_start;
+    stop = pending_stop;
+    return clip(start, stop);
+  }
+
+private:
+  // Only the segment folded in from before lo can end up empty, when the
+  // range itself is empty.
+  bool clip(Coord start, Coord &stop) const {
+    if (!unbounded)
+      stop = std::min(stop, hi);
+    return start < stop;
+  }
+};
+
+// A single segment, [start, stop) clipped to the range being swept.
+template <typename Coord> class SpanCursor {
+private:
+  Coord start, stop;
+  bool done;
+
+public:
+  SpanCursor(Coord start, Coord stop, Coord lo, Coord hi, bool unbounded)
+      : start(std::max(start, lo)), stop(unbounded ? stop : std::min(stop, hi)),
+        done(this->start >= this->stop) {}
+
+  bool next(Coord &s, Coord &e) {
+    if (done)
+      return false;
+    done = true;
+    s = start;
+    e = stop;
+    return true;
+  }
+};
+
+template <typename X, typename Y, typename I>
+void intersect_streams(X &x, Y &y, std::vector<I> &out) {
+  using Coord = decltype(I::start);
+  Coord xs, xe, ys, ye;
+  bool has_x = x.next(xs, xe), has_y = y.next(ys, ye);
+  while (has_x && has_y) {
+    Coord s = std::max(xs, ys), e = std::min(xe, ye);
+    if (s < e)
+      out.push_back({s, e, {}});
+    if (xe < ye)
+      has_x = x.next(xs, xe);
+    else
+      has_y = y.next(ys, ye);
+  }
+}
+
+template <typename X, typename Y, typename I>
+void subtract_streams(X &x, Y &y, std::vector<I> &out) {
+  using Coord = decltype(I::start);
+  Coord xs, xe, ys, ye;
+  bool has_y = y.next(ys, ye);
+  while (x.next(xs, xe)) {
+    Coord cur = xs;
+    while (has_y && ye <= cur)
+      has_y = y.next(ys, ye);
+    while (has_y && ys < xe) {
+      if (ys > cur)
+        out.push_back({cur, ys, {}});
+      cur = std::max(cur, ye);
+      if (ye >= xe)
+        break;
+      has_y = y.next(ys, ye);
+    }
+    if (cur < xe)
+      out.push_back({cur, xe, {}});
+  }
+}
+
+// Runs sweep(lo, hi, unbounded, out) over coordinate ranges cut at quantiles
+// of v's starts, then concatenates the pieces in order, joining pieces that
+// meet at a cut.
+template <typename Coord, typename Val, typename Sweep>
+BasicLapper<Coord, Val> run_ranges(const BasicLapperView<Coord, Val> &v,
+                                   unsigned threads, Sweep &&sweep) {
+  using I = BasicInterval<Coord, Val>;
+  threads = std::max(1u, std::min<unsigned>(threads, v.length / 1024 + 1));
+  std::vector<Coord> cuts(threads + 1, 0);
+  for (unsigned t = 1; t < threads; t++)
+    cuts[t] = v.starts_sorted[v.length * t / threads];
+
+  std::vector<std::vector<I>> parts(threads);
+  parallel_chunks(threads, threads, [&](unsigned, size_t begin, size_t end) {
+    for (size_t t = begin; t < end; t++)
+      sweep(cuts[t], cuts[t + 1], t == threads - 1, parts[t]);
+  });
+
+  std::vector<I> out;
+  if (threads == 1) {
+    out = std::move(parts[0]);
+  } else {
+    size_t total = 0;
+    for (const std::vector<I> &p : parts)
+      total += p.size();
+    out.reserve(total);
+    for (const std::vector<I> &p : parts) {
+      auto it = p.begin();
+      if (it != p.end() && !out.empty() && out.back().stop == it->start)
+        out.back().stop = (it++)->stop;
+      out.insert(out.end(), it, p.end());
+    }
+  }
+  return BasicLapper<Coord, Val>::from_sorted(std::move(out));
+}
+
+} // namespace set_ops_detail
+
+// The union of a's intervals as disjoint intervals.
+template <typename Coord, typename Val>
+BasicLapper<Coord, Val> merge_overlaps(const BasicLapperView<Coord, Val> &a,
+                                       unsigned threads = default_threads()) {
+  using namespace set_ops_detail;
+  return run_ranges(a, threads,
+                    [&](Coord lo, Coord hi, bool unbounded,
+                        std::vector<BasicInterval<Coord, Val>> &out) {
+                      UnionCursor<Coord, Val> x(a, lo, hi, unbounded);
+                      Coord s, e;
+                      while (x.next(s, e))
+                        out.push_back({s, e, {}});
+                    });
+}
+
+// Coordinates covered by both a and b.
+template <typename Coord, typename Val>
+BasicLapper<Coord, Val> intersect(const BasicLapperView<Coord, Val> &a,
+                                  const BasicLapperView<Coord, Val> &b,
+                                  unsigned threads = default_threads()) {
+  using namespace set_ops_detail;
+  return run_ranges(a, threads,
+                    [&](Coord lo, Coord hi, bool unbounded,
+                        std::vector<BasicInterval<Coord, Val>> &out) {
+                      UnionCursor<Coord, Val> x(a, lo, hi, unbounded);
+                      UnionCursor<Coord, Val> y(b, lo, hi, unbounded);
+                      intersect_streams(x, y, out);
+                    });
+}
+
+// Coordinates covered by a but not by b, e.g. annotations minus an exclusion
+// list.
+template <typename Coord, typename Val>
+BasicLapper<Coord, Val> subtract(const BasicLapperView<Coord, Val> &a,
+                                 const BasicLapperView<Coord, Val> &b,
+                                 unsigned threads = default_threads()) {
+  using namespace set_ops_detail;
+  return run_ranges(a, threads,
+                    [&](Coord lo, Coord hi, bool unbounded,
+                        std::vector<BasicInterval<Coord, Val>> &out) {
+                      UnionCursor<Coord, Val> x(a, lo, hi, unbounded);
+                      UnionCursor<Coord, Val> y(b, lo, hi, unbounded);
+                      subtract_streams(x, y, out);
+                    });
+}
+
+// Coordinates in [lo, hi), e.g. a contig's bounds, covered by nothing in a.
+template <typename Coord, typename Val>
+BasicLapper<Coord, Val> complement(const BasicLapperView<Coord, Val> &a,
+                                   Coord lo, Coord hi,
+                                   unsigned threads = default_threads()) {
+  using namespace set_ops_detail;
+  return run_ranges(a, threads,
+                    [&](Coord range_lo, Coord range_hi, bool unbounded,
+                        std::vector<BasicInterval<Coord, Val>> &out) {
+                      SpanCursor<Coord> x(lo, hi, range_lo, range_hi,
+                                          unbounded);
+                      UnionCursor<Coord, Val> y(a, range_lo, range_hi,
+                                                unbounded);
+                      subtract_streams(x, y, out);
+                    });
+}